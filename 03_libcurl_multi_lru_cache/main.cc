@@ -0,0 +1,714 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <list>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <charconv>
+#include <coroutine>
+#include <utility>
+#include <cctype>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// response cache configuration
+struct CURL_CacheOptions
+{
+    // upper bound for all cached bodies + keys + validators;
+    // 0 disables caching
+    std::size_t capacity_bytes = 0;
+    // freshness to assume when server sends no Cache-Control: max-age;
+    // 0 means "always revalidate" (If-None-Match/If-Modified-Since)
+    std::chrono::seconds default_max_age{0};
+};
+
+struct CURL_CacheStats
+{
+    std::size_t fresh_hits = 0;
+    std::size_t revalidated = 0; // 304 Not Modified
+    std::size_t misses = 0;      // full 200 response
+    std::size_t evictions = 0;
+    std::size_t size_bytes = 0;
+};
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create(const CURL_CacheOptions& cache_options = {});
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+CURL_CacheStats CURL_async_cache_stats(CURL_Async curl_async);
+
+// main async callback API;
+// fresh cache hit invokes the callback synchronously, before return
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+// returns true and fills response for fresh cache hit, nothing is started
+bool CURL_async_try_get_cached(CURL_Async curl_async
+    , const std::string& url
+    , std::string& response);
+
+// blocking API, shares the cache with the scheduler
+std::string CURL_get(CURL_Async curl_async, const std::string& url);
+
+// coro await
+struct Co_CurlAsync;
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+static std::string_view CURL_Trim(std::string_view str)
+{
+    while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front())))
+    {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && std::isspace(static_cast<unsigned char>(str.back())))
+    {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+static bool CURL_IEquals(std::string_view lhs, std::string_view rhs)
+{
+    if (lhs.size() != rhs.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i)
+    {
+        if (std::tolower(static_cast<unsigned char>(lhs[i]))
+            != std::tolower(static_cast<unsigned char>(rhs[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// subset of response headers relevant for caching
+struct CURL_CacheHeaders
+{
+    std::string etag;
+    std::string last_modified;
+    bool has_max_age = false;
+    std::chrono::seconds max_age{0};
+    bool no_store = false;
+
+    void parse_line(std::string_view line);
+    void parse_cache_control(std::string_view value);
+};
+
+void CURL_CacheHeaders::parse_line(std::string_view line)
+{
+    if (line.starts_with("HTTP/"))
+    {   // new status line (redirect, 100-continue): forget previous headers
+        *this = CURL_CacheHeaders{};
+        return;
+    }
+    const std::size_t colon = line.find(':');
+    if (colon == std::string_view::npos)
+    {
+        return;
+    }
+    const std::string_view name = CURL_Trim(line.substr(0, colon));
+    const std::string_view value = CURL_Trim(line.substr(colon + 1));
+    if (CURL_IEquals(name, "ETag"))
+    {
+        etag = value;
+    }
+    else if (CURL_IEquals(name, "Last-Modified"))
+    {
+        last_modified = value;
+    }
+    else if (CURL_IEquals(name, "Cache-Control"))
+    {
+        parse_cache_control(value);
+    }
+}
+
+void CURL_CacheHeaders::parse_cache_control(std::string_view value)
+{
+    while (!value.empty())
+    {
+        const std::size_t comma = value.find(',');
+        const std::string_view directive = CURL_Trim(value.substr(0, comma));
+        value = (comma == std::string_view::npos) ? std::string_view{} : value.substr(comma + 1);
+
+        if (CURL_IEquals(directive, "no-store"))
+        {
+            no_store = true;
+        }
+        else if (CURL_IEquals(directive, "no-cache"))
+        {   // may be stored, but must be revalidated every time
+            has_max_age = true;
+            max_age = std::chrono::seconds{0};
+        }
+        else if ((directive.size() > 8) && CURL_IEquals(directive.substr(0, 8), "max-age="))
+        {
+            const std::string_view number = directive.substr(8);
+            long long seconds = 0;
+            const auto [_, ec] = std::from_chars(number.data(), number.data() + number.size(), seconds);
+            if (ec == std::errc{})
+            {
+                has_max_age = true;
+                max_age = std::chrono::seconds{seconds};
+            }
+        }
+    }
+}
+
+static size_t CURL_OnHeaderCallback(char* buffer, size_t size, size_t nitems, void* data)
+{
+    CURL_CacheHeaders& headers = *static_cast<CURL_CacheHeaders*>(data);
+    headers.parse_line(std::string_view(buffer, size * nitems));
+    return (size * nitems);
+}
+
+// size-bounded, in-memory LRU cache of GET responses
+struct CURL_ResponseCache
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        std::string url;
+        // shared, so in-flight revalidation keeps the body alive
+        // even if the entry is evicted in the meantime
+        std::shared_ptr<const std::string> body;
+        std::string etag;
+        std::string last_modified;
+        Clock::time_point expires_at;
+
+        std::size_t size_bytes() const
+        {
+            return (url.size() + body->size() + etag.size() + last_modified.size());
+        }
+    };
+
+    explicit CURL_ResponseCache(const CURL_CacheOptions& options)
+        : _options{options} {}
+    // no copy, no move: _url_to_entry points into _lru
+    CURL_ResponseCache(const CURL_ResponseCache&) = delete;
+
+    // any entry (fresh or stale); marks it as most recently used
+    Entry* find(std::string_view url);
+    Entry* find_fresh(std::string_view url);
+    void store(const std::string& url, std::string body, const CURL_CacheHeaders& headers);
+    // 304 Not Modified
+    void refresh(std::string_view url, const CURL_CacheHeaders& headers);
+
+    bool is_enabled() const
+    {
+        return (_options.capacity_bytes > 0);
+    }
+
+    Clock::time_point expires_at(const CURL_CacheHeaders& headers) const;
+    void remove(std::list<Entry>::iterator it);
+    void evict_to_fit(std::size_t extra_bytes);
+
+    CURL_CacheOptions _options;
+    CURL_CacheStats _stats;
+    // front is the most recently used
+    std::list<Entry> _lru;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> _url_to_entry;
+};
+
+CURL_ResponseCache::Entry* CURL_ResponseCache::find(std::string_view url)
+{
+    auto it = _url_to_entry.find(url);
+    if (it == _url_to_entry.end())
+    {
+        return nullptr;
+    }
+    _lru.splice(_lru.begin(), _lru, it->second);
+    return &*it->second;
+}
+
+CURL_ResponseCache::Entry* CURL_ResponseCache::find_fresh(std::string_view url)
+{
+    Entry* entry = find(url);
+    if (entry && (Clock::now() < entry->expires_at))
+    {
+        return entry;
+    }
+    return nullptr;
+}
+
+CURL_ResponseCache::Clock::time_point CURL_ResponseCache::expires_at(const CURL_CacheHeaders& headers) const
+{
+    const std::chrono::seconds max_age = headers.has_max_age
+        ? headers.max_age
+        : _options.default_max_age;
+    return (Clock::now() + max_age);
+}
+
+void CURL_ResponseCache::store(const std::string& url, std::string body, const CURL_CacheHeaders& headers)
+{
+    if (!is_enabled() || headers.no_store)
+    {
+        return;
+    }
+    if (auto it = _url_to_entry.find(url); it != _url_to_entry.end())
+    {
+        remove(it->second);
+    }
+    Entry entry;
+    entry.url = url;
+    entry.body = std::make_shared<const std::string>(std::move(body));
+    entry.etag = headers.etag;
+    entry.last_modified = headers.last_modified;
+    entry.expires_at = expires_at(headers);
+    const std::size_t size_bytes = entry.size_bytes();
+    if (size_bytes > _options.capacity_bytes)
+    {   // would evict everything and still not fit
+        return;
+    }
+    evict_to_fit(size_bytes);
+    _lru.push_front(std::move(entry));
+    _url_to_entry[_lru.front().url] = _lru.begin();
+    _stats.size_bytes += size_bytes;
+}
+
+void CURL_ResponseCache::refresh(std::string_view url, const CURL_CacheHeaders& headers)
+{
+    Entry* entry = find(url);
+    if (!entry)
+    {   // evicted while revalidating
+        return;
+    }
+    // 304 may carry updated validators
+    if (!headers.etag.empty())
+    {
+        _stats.size_bytes -= entry->size_bytes();
+        entry->etag = headers.etag;
+        _stats.size_bytes += entry->size_bytes();
+    }
+    entry->expires_at = expires_at(headers);
+}
+
+void CURL_ResponseCache::remove(std::list<Entry>::iterator it)
+{
+    _stats.size_bytes -= it->size_bytes();
+    (void)_url_to_entry.erase(it->url);
+    (void)_lru.erase(it);
+}
+
+void CURL_ResponseCache::evict_to_fit(std::size_t extra_bytes)
+{
+    while (!_lru.empty() && (_stats.size_bytes + extra_bytes > _options.capacity_bytes))
+    {
+        remove(std::prev(_lru.end()));
+        ++_stats.evictions;
+    }
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler(const CURL_CacheOptions& cache_options);
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+    CURL_ResponseCache _cache;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler(const CURL_CacheOptions& cache_options)
+    : _cache{cache_options}
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+CURL_Async CURL_async_create(const CURL_CacheOptions& cache_options /*= {}*/)
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler(cache_options);
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+CURL_CacheStats CURL_async_cache_stats(CURL_Async curl_async)
+{
+    return CURL_scheduler(curl_async)._cache._stats;
+}
+
+// per-request state, shared by blocking and async paths
+struct CURL_CachedRequest
+{
+    std::string url;
+    std::string response;
+    CURL_CacheHeaders headers;
+    curl_slist* conditional_headers = nullptr;
+    // stale body to return on 304
+    std::shared_ptr<const std::string> stale_body;
+};
+
+static CURL* CURL_StartRequest(CURL_ResponseCache& cache, CURL_CachedRequest& request)
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, request.url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data and cache-related headers
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, &request.response);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_HEADERFUNCTION, CURL_OnHeaderCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_HEADERDATA, &request.headers);
+    assert(status == CURLE_OK);
+
+    // 3. stale entry: ask server to confirm it is still valid
+    if (const CURL_ResponseCache::Entry* stale = cache.find(request.url))
+    {
+        request.stale_body = stale->body;
+        if (!stale->etag.empty())
+        {
+            const std::string header = "If-None-Match: " + stale->etag;
+            request.conditional_headers = curl_slist_append(request.conditional_headers, header.c_str());
+            assert(request.conditional_headers);
+        }
+        if (!stale->last_modified.empty())
+        {
+            const std::string header = "If-Modified-Since: " + stale->last_modified;
+            request.conditional_headers = curl_slist_append(request.conditional_headers, header.c_str());
+            assert(request.conditional_headers);
+        }
+        status = curl_easy_setopt(curl_easy, CURLOPT_HTTPHEADER, request.conditional_headers);
+        assert(status == CURLE_OK);
+    }
+    return curl_easy;
+}
+
+static std::string CURL_FinishRequest(CURL_ResponseCache& cache, CURL* curl_easy, CURL_CachedRequest& request)
+{
+    long response_code = -1;
+    const CURLcode status = curl_easy_getinfo(curl_easy, CURLINFO_RESPONSE_CODE, &response_code);
+    assert(status == CURLE_OK);
+    curl_easy_cleanup(curl_easy);
+    curl_slist_free_all(request.conditional_headers);
+    request.conditional_headers = nullptr;
+
+    if (response_code == 304L)
+    {
+        assert(request.stale_body);
+        ++cache._stats.revalidated;
+        cache.refresh(request.url, request.headers);
+        return *request.stale_body;
+    }
+    assert(response_code == 200L);
+    ++cache._stats.misses;
+    cache.store(request.url, request.response, request.headers);
+    return std::move(request.response);
+}
+
+bool CURL_async_try_get_cached(CURL_Async curl_async
+    , const std::string& url
+    , std::string& response)
+{
+    CURL_ResponseCache& cache = CURL_scheduler(curl_async)._cache;
+    if (const CURL_ResponseCache::Entry* fresh = cache.find_fresh(url))
+    {
+        ++cache._stats.fresh_hits;
+        response = *fresh->body;
+        return true;
+    }
+    return false;
+}
+
+std::string CURL_get(CURL_Async curl_async, const std::string& url)
+{
+    std::string response;
+    if (CURL_async_try_get_cached(curl_async, url, response))
+    {
+        return response;
+    }
+    CURL_ResponseCache& cache = CURL_scheduler(curl_async)._cache;
+    CURL_CachedRequest request;
+    request.url = url;
+    CURL* curl_easy = CURL_StartRequest(cache, request);
+    const CURLcode status = curl_easy_perform(curl_easy);
+    assert(status == CURLE_OK);
+    return CURL_FinishRequest(cache, curl_easy, request);
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // 0. fresh hit, no need to touch the network
+    std::string cached;
+    if (CURL_async_try_get_cached(curl_async, url, cached))
+    {
+        callback(user_data, std::move(cached));
+        return;
+    }
+
+    // 1-3. setup curl easy handle, conditional headers if stale
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(curl_async);
+    CURL_CachedRequest* state = new CURL_CachedRequest{};
+    state->url = url;
+    CURL* curl_easy = CURL_StartRequest(scheduler._cache, *state);
+
+    // 4. associate with multi handle/event loop
+    scheduler.add_request(curl_easy
+        , [&scheduler, state, user_data, callback](CURL* curl_easy_)
+    {
+        std::string data = CURL_FinishRequest(scheduler._cache, curl_easy_, *state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+}
+
+struct Co_Task
+{
+    struct promise_type;
+    using co_handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type
+    {
+        Co_Task get_return_object()
+        {
+            return Co_Task{co_handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+            // yeah, we return void. Nothing to do
+        }
+
+        void unhandled_exception()
+        {
+            // crash, no exceptions handling
+            assert(false);
+        }
+    };
+
+    Co_Task(co_handle coro)
+        : _coro{coro} {}
+    Co_Task(Co_Task&& rhs) noexcept
+        : _coro{std::exchange(rhs._coro, {})} { }
+    Co_Task(const Co_Task&) = delete;
+    ~Co_Task() noexcept
+    {
+        if (_coro)
+        {
+            _coro.destroy();
+        }
+    }
+
+    void resume()
+    {
+        assert(_coro);
+        assert(!_coro.done());
+        _coro.resume();
+    }
+
+    bool is_in_progress() const
+    {
+        assert(_coro);
+        return !_coro.done();
+    }
+
+    co_handle _coro;
+};
+
+struct Co_CurlAsync
+{
+    CURL_Async _curl_async{};
+    std::string _url;
+    std::coroutine_handle<> _coro;
+    std::string _response;
+
+    bool await_ready()
+    { // 1. fresh cache hit: no suspension at all
+        return CURL_async_try_get_cached(_curl_async, _url, _response);
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    { // 2. remember coroutine handle, start request, resume on finish:
+        _coro = coro;
+
+        CURL_async_get(_curl_async, _url, this
+            , [](void* user_data, std::string response)
+        {
+            Co_CurlAsync& self = *static_cast<Co_CurlAsync*>(user_data);
+            self._response = std::move(response);
+            self._coro.resume();
+        });
+    }
+
+    std::string await_resume()
+    { // 3. after resume (or no suspend), return response:
+        return std::move(_response);
+    }
+};
+
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url)
+{
+    Co_CurlAsync awaiter;
+    awaiter._curl_async = curl_async;
+    awaiter._url = url;
+    return awaiter;
+}
+
+static Co_Task coro_main(CURL_Async curl_async)
+{
+    // miss, goes to the network
+    const std::string r1 = co_await CURL_await_get(
+        curl_async, "localhost:5001/file1.txt");
+    // fresh hit, await_ready() returns true
+    const std::string r2 = co_await CURL_await_get(
+        curl_async, "localhost:5001/file1.txt");
+    std::println("coro_main responses: '{}', '{}'", r1, r2);
+    co_return;
+}
+
+static void print_stats(const char* title, const CURL_CacheStats& stats)
+{
+    std::println("{}: fresh hits {}, revalidated {}, misses {}, evictions {}, size {} bytes"
+        , title
+        , stats.fresh_hits
+        , stats.revalidated
+        , stats.misses
+        , stats.evictions
+        , stats.size_bytes);
+}
+
+int main()
+{
+    CURL_CacheOptions cache_options;
+    cache_options.capacity_bytes = 64 * 1024;
+    // http.server sends Last-Modified, but no Cache-Control
+    cache_options.default_max_age = std::chrono::seconds{1};
+    CURL_Async curl_async = CURL_async_create(cache_options);
+
+    Co_Task task = coro_main(curl_async);
+    task.resume();
+    while (task.is_in_progress())
+    {
+        CURL_async_tick(curl_async);
+    }
+    print_stats("after coroutine", CURL_async_cache_stats(curl_async));
+
+    // fresh hit, callback is invoked synchronously
+    bool done = false;
+    CURL_async_get(curl_async, "localhost:5001/file1.txt", &done
+        , [](void* user_data, std::string response)
+    {
+        std::println("async response: '{}'", response);
+        *static_cast<bool*>(user_data) = true;
+    });
+    assert(done);
+
+    // stale, revalidated with If-Modified-Since: 304
+    std::this_thread::sleep_for(std::chrono::milliseconds{1100});
+    const std::string r = CURL_get(curl_async, "localhost:5001/file1.txt");
+    std::println("CURL_get(file1.txt): '{}'", r);
+    print_stats("after revalidation", CURL_async_cache_stats(curl_async));
+
+    CURL_async_destroy(curl_async);
+}
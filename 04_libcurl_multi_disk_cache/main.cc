@@ -0,0 +1,990 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <filesystem>
+#include <fstream>
+#include <chrono>
+#include <charconv>
+#include <coroutine>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <Windows.h>
+#else
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// persistent response cache configuration
+struct CURL_DiskCacheOptions
+{
+    // holds index.bin and one <url hash>.body file per response
+    std::string directory;
+    // fixed-size, open-addressing index; power of 2
+    std::uint32_t index_slots = 4096;
+    // freshness to assume when server sends no Cache-Control: max-age;
+    // 0 means "always revalidate" (If-None-Match/If-Modified-Since)
+    std::chrono::seconds default_max_age{0};
+};
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create(const CURL_DiskCacheOptions& cache_options);
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+
+// main async callback API;
+// fresh cache hit invokes the callback synchronously, before return
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+// same as above, but response is valid only during the callback;
+// disk cache hits point directly into memory-mapped file, no copy
+void CURL_async_get_view(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string_view response));
+
+// returns true and fills response for fresh cache hit, nothing is started
+bool CURL_async_try_get_cached(CURL_Async curl_async
+    , const std::string& url
+    , std::string& response);
+
+// coro await
+struct Co_CurlAsync;
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+static std::string_view CURL_Trim(std::string_view str)
+{
+    while (!str.empty() && std::isspace(static_cast<unsigned char>(str.front())))
+    {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && std::isspace(static_cast<unsigned char>(str.back())))
+    {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+static bool CURL_IEquals(std::string_view lhs, std::string_view rhs)
+{
+    if (lhs.size() != rhs.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i)
+    {
+        if (std::tolower(static_cast<unsigned char>(lhs[i]))
+            != std::tolower(static_cast<unsigned char>(rhs[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// subset of response headers relevant for caching
+struct CURL_CacheHeaders
+{
+    std::string etag;
+    std::string last_modified;
+    bool has_max_age = false;
+    std::chrono::seconds max_age{0};
+    bool no_store = false;
+
+    void parse_line(std::string_view line);
+    void parse_cache_control(std::string_view value);
+};
+
+void CURL_CacheHeaders::parse_line(std::string_view line)
+{
+    if (line.starts_with("HTTP/"))
+    {   // new status line (redirect, 100-continue): forget previous headers
+        *this = CURL_CacheHeaders{};
+        return;
+    }
+    const std::size_t colon = line.find(':');
+    if (colon == std::string_view::npos)
+    {
+        return;
+    }
+    const std::string_view name = CURL_Trim(line.substr(0, colon));
+    const std::string_view value = CURL_Trim(line.substr(colon + 1));
+    if (CURL_IEquals(name, "ETag"))
+    {
+        etag = value;
+    }
+    else if (CURL_IEquals(name, "Last-Modified"))
+    {
+        last_modified = value;
+    }
+    else if (CURL_IEquals(name, "Cache-Control"))
+    {
+        parse_cache_control(value);
+    }
+}
+
+void CURL_CacheHeaders::parse_cache_control(std::string_view value)
+{
+    while (!value.empty())
+    {
+        const std::size_t comma = value.find(',');
+        const std::string_view directive = CURL_Trim(value.substr(0, comma));
+        value = (comma == std::string_view::npos) ? std::string_view{} : value.substr(comma + 1);
+
+        if (CURL_IEquals(directive, "no-store"))
+        {
+            no_store = true;
+        }
+        else if (CURL_IEquals(directive, "no-cache"))
+        {   // may be stored, but must be revalidated every time
+            has_max_age = true;
+            max_age = std::chrono::seconds{0};
+        }
+        else if ((directive.size() > 8) && CURL_IEquals(directive.substr(0, 8), "max-age="))
+        {
+            const std::string_view number = directive.substr(8);
+            long long seconds = 0;
+            const auto [_, ec] = std::from_chars(number.data(), number.data() + number.size(), seconds);
+            if (ec == std::errc{})
+            {
+                has_max_age = true;
+                max_age = std::chrono::seconds{seconds};
+            }
+        }
+    }
+}
+
+static size_t CURL_OnHeaderCallback(char* buffer, size_t size, size_t nitems, void* data)
+{
+    CURL_CacheHeaders& headers = *static_cast<CURL_CacheHeaders*>(data);
+    headers.parse_line(std::string_view(buffer, size * nitems));
+    return (size * nitems);
+}
+
+// whole-file memory mapping; read-only or read-write of a fixed size
+struct CURL_MappedFile
+{
+    CURL_MappedFile() = default;
+    CURL_MappedFile(CURL_MappedFile&& rhs) noexcept
+        : _data{std::exchange(rhs._data, nullptr)}
+        , _size{std::exchange(rhs._size, 0)}
+#if defined(_WIN32)
+        , _file{std::exchange(rhs._file, INVALID_HANDLE_VALUE)}
+        , _mapping{std::exchange(rhs._mapping, nullptr)}
+#else
+        , _fd{std::exchange(rhs._fd, -1)}
+#endif
+    {
+    }
+    CURL_MappedFile(const CURL_MappedFile&) = delete;
+    ~CURL_MappedFile()
+    {
+        close();
+    }
+
+    // false if file does not exist or is empty
+    bool open_read(const std::filesystem::path& path);
+    // creates (zero-filled) or resizes file to exactly size bytes
+    bool open_write(const std::filesystem::path& path, std::size_t size);
+    void close();
+
+    std::string_view view() const
+    {
+        return std::string_view(static_cast<const char*>(_data), _size);
+    }
+
+    void* _data = nullptr;
+    std::size_t _size = 0;
+#if defined(_WIN32)
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#else
+    int _fd = -1;
+#endif
+};
+
+#if defined(_WIN32)
+bool CURL_MappedFile::open_read(const std::filesystem::path& path)
+{
+    assert(!_data);
+    _file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE
+        , nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size{};
+    if ((_file == INVALID_HANDLE_VALUE) || !::GetFileSizeEx(_file, &size) || (size.QuadPart == 0))
+    {
+        close();
+        return false;
+    }
+    _mapping = ::CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    assert(_mapping);
+    _data = ::MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+    assert(_data);
+    _size = static_cast<std::size_t>(size.QuadPart);
+    return true;
+}
+
+bool CURL_MappedFile::open_write(const std::filesystem::path& path, std::size_t size)
+{
+    assert(!_data);
+    assert(size > 0);
+    _file = ::CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ
+        , nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER new_size{};
+    new_size.QuadPart = static_cast<LONGLONG>(size);
+    BOOL ok = ::SetFilePointerEx(_file, new_size, nullptr, FILE_BEGIN);
+    assert(ok);
+    ok = ::SetEndOfFile(_file);
+    assert(ok);
+    _mapping = ::CreateFileMappingW(_file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    assert(_mapping);
+    _data = ::MapViewOfFile(_mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+    assert(_data);
+    _size = size;
+    return true;
+}
+
+void CURL_MappedFile::close()
+{
+    if (_data)
+    {
+        (void)::UnmapViewOfFile(_data);
+    }
+    if (_mapping)
+    {
+        (void)::CloseHandle(_mapping);
+    }
+    if (_file != INVALID_HANDLE_VALUE)
+    {
+        (void)::CloseHandle(_file);
+    }
+    _data = nullptr;
+    _size = 0;
+    _mapping = nullptr;
+    _file = INVALID_HANDLE_VALUE;
+}
+#else
+bool CURL_MappedFile::open_read(const std::filesystem::path& path)
+{
+    assert(!_data);
+    _fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info{};
+    if ((_fd == -1) || (::fstat(_fd, &info) != 0) || (info.st_size == 0))
+    {
+        close();
+        return false;
+    }
+    _size = static_cast<std::size_t>(info.st_size);
+    _data = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+    assert(_data != MAP_FAILED);
+    return true;
+}
+
+bool CURL_MappedFile::open_write(const std::filesystem::path& path, std::size_t size)
+{
+    assert(!_data);
+    assert(size > 0);
+    _fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (_fd == -1)
+    {
+        return false;
+    }
+    const int status = ::ftruncate(_fd, static_cast<off_t>(size));
+    assert(status == 0);
+    _size = size;
+    _data = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    assert(_data != MAP_FAILED);
+    return true;
+}
+
+void CURL_MappedFile::close()
+{
+    if (_data)
+    {
+        (void)::munmap(_data, _size);
+    }
+    if (_fd != -1)
+    {
+        (void)::close(_fd);
+    }
+    _data = nullptr;
+    _size = 0;
+    _fd = -1;
+}
+#endif
+
+// persistent cache: index.bin is a memory-mapped open-addressing table
+// of fixed-size slots, bodies are separate files mapped on lookup.
+// Nothing is read at startup; index pages are faulted in on first access
+struct CURL_DiskCache
+{
+    static constexpr std::uint32_t kIndexMagic = 0x58444943; // "CIDX"
+    static constexpr std::uint32_t kBodyMagic = 0x59444F42;  // "BODY"
+    static constexpr std::uint32_t kMaxProbes = 8;
+    // slot.url_hash of removed entry: lookups probe past it, inserts reuse it
+    static constexpr std::uint64_t kTombstone = 1;
+
+    struct IndexHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t slot_count;
+    };
+
+    struct IndexSlot
+    {
+        std::uint64_t url_hash;      // 0 for empty slot, kTombstone for removed
+        std::int64_t expires_at;     // unix seconds
+        std::uint64_t body_size;
+    };
+
+    // on-disk layout of .body file: header, url, etag, last_modified, body
+    struct BodyHeader
+    {
+        std::uint32_t magic;
+        std::uint32_t url_size;
+        std::uint32_t etag_size;
+        std::uint32_t last_modified_size;
+        std::uint64_t body_size;
+    };
+
+    // mapped .body file of cache hit
+    struct Entry
+    {
+        CURL_MappedFile file;
+        std::string_view body;
+        std::string_view etag;
+        std::string_view last_modified;
+        bool is_fresh = false;
+    };
+
+    explicit CURL_DiskCache(const CURL_DiskCacheOptions& options);
+    // no copy, no move
+    CURL_DiskCache(const CURL_DiskCache&) = delete;
+
+    bool find(const std::string& url, Entry& entry);
+    void store(const std::string& url, std::string_view body, const CURL_CacheHeaders& headers);
+    // 304 Not Modified
+    void refresh(const std::string& url, const CURL_CacheHeaders& headers);
+
+    static std::uint64_t hash(std::string_view url);
+    static std::int64_t now_unix();
+    std::filesystem::path body_path(std::uint64_t url_hash) const;
+    IndexSlot* slots();
+    IndexSlot* find_slot(std::uint64_t url_hash, bool for_insert);
+    std::int64_t expires_at(const CURL_CacheHeaders& headers) const;
+
+    CURL_DiskCacheOptions _options;
+    std::filesystem::path _directory;
+    // lazily mapped on first use
+    CURL_MappedFile _index;
+};
+
+CURL_DiskCache::CURL_DiskCache(const CURL_DiskCacheOptions& options)
+    : _options{options}
+    , _directory{options.directory}
+{
+    assert(!_directory.empty());
+    assert((_options.index_slots > 0)
+        && ((_options.index_slots & (_options.index_slots - 1)) == 0));
+}
+
+std::uint64_t CURL_DiskCache::hash(std::string_view url)
+{   // FNV-1a, stable across runs and platforms
+    std::uint64_t h = 14695981039346656037ull;
+    for (char c : url)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    // 0 and kTombstone are reserved for slot states
+    return ((h <= kTombstone) ? (h + kTombstone + 1) : h);
+}
+
+std::int64_t CURL_DiskCache::now_unix()
+{
+    using namespace std::chrono;
+    return duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+}
+
+std::filesystem::path CURL_DiskCache::body_path(std::uint64_t url_hash) const
+{
+    char name[32]{};
+    const auto [end, ec] = std::to_chars(name, name + sizeof(name), url_hash, 16);
+    assert(ec == std::errc{});
+    return (_directory / (std::string(name, end) + ".body"));
+}
+
+CURL_DiskCache::IndexSlot* CURL_DiskCache::slots()
+{
+    if (_index._data)
+    {
+        return reinterpret_cast<IndexSlot*>(static_cast<char*>(_index._data) + sizeof(IndexHeader));
+    }
+    std::error_code ec;
+    (void)std::filesystem::create_directories(_directory, ec);
+    const std::size_t size = sizeof(IndexHeader) + _options.index_slots * sizeof(IndexSlot);
+    const bool ok = _index.open_write(_directory / "index.bin", size);
+    assert(ok);
+    IndexHeader& header = *static_cast<IndexHeader*>(_index._data);
+    if ((header.magic != kIndexMagic) || (header.slot_count != _options.index_slots))
+    {   // new or incompatible index: start from scratch, old bodies are orphaned
+        std::memset(_index._data, 0, size);
+        header.magic = kIndexMagic;
+        header.slot_count = _options.index_slots;
+    }
+    return reinterpret_cast<IndexSlot*>(static_cast<char*>(_index._data) + sizeof(IndexHeader));
+}
+
+CURL_DiskCache::IndexSlot* CURL_DiskCache::find_slot(std::uint64_t url_hash, bool for_insert)
+{
+    IndexSlot* table = slots();
+    const std::uint32_t mask = _options.index_slots - 1;
+    IndexSlot* reusable = nullptr;
+    for (std::uint32_t i = 0; i < kMaxProbes; ++i)
+    {
+        IndexSlot& slot = table[(url_hash + i) & mask];
+        if (slot.url_hash == url_hash)
+        {
+            return &slot;
+        }
+        if (slot.url_hash == kTombstone)
+        {   // keep probing: the entry may sit further in the chain
+            reusable = (reusable ? reusable : &slot);
+            continue;
+        }
+        if (slot.url_hash == 0)
+        {
+            return (for_insert ? (reusable ? reusable : &slot) : nullptr);
+        }
+    }
+    if (!for_insert)
+    {
+        return nullptr;
+    }
+    if (reusable)
+    {
+        return reusable;
+    }
+    // probe sequence is full: replace home slot; tombstone, not empty,
+    // so entries further in the chain stay reachable
+    IndexSlot& victim = table[url_hash & mask];
+    std::error_code ec;
+    (void)std::filesystem::remove(body_path(victim.url_hash), ec);
+    victim = IndexSlot{};
+    victim.url_hash = kTombstone;
+    return &victim;
+}
+
+std::int64_t CURL_DiskCache::expires_at(const CURL_CacheHeaders& headers) const
+{
+    const std::chrono::seconds max_age = headers.has_max_age
+        ? headers.max_age
+        : _options.default_max_age;
+    return (now_unix() + max_age.count());
+}
+
+bool CURL_DiskCache::find(const std::string& url, Entry& entry)
+{
+    const std::uint64_t url_hash = hash(url);
+    const IndexSlot* slot = find_slot(url_hash, false/*for_insert*/);
+    if (!slot)
+    {
+        return false;
+    }
+    if (!entry.file.open_read(body_path(url_hash)))
+    {
+        return false;
+    }
+    const std::string_view data = entry.file.view();
+    if (data.size() < sizeof(BodyHeader))
+    {
+        entry.file.close();
+        return false;
+    }
+    BodyHeader header{};
+    std::memcpy(&header, data.data(), sizeof(header));
+    const std::size_t total = sizeof(BodyHeader) + header.url_size
+        + header.etag_size + header.last_modified_size + header.body_size;
+    if ((header.magic != kBodyMagic) || (total != data.size())
+        || (header.body_size != slot->body_size))
+    {   // torn write or foreign file
+        entry.file.close();
+        return false;
+    }
+    std::size_t offset = sizeof(BodyHeader);
+    const std::string_view stored_url = data.substr(offset, header.url_size);
+    offset += header.url_size;
+    if (stored_url != url)
+    {   // hash collision
+        entry.file.close();
+        return false;
+    }
+    entry.etag = data.substr(offset, header.etag_size);
+    offset += header.etag_size;
+    entry.last_modified = data.substr(offset, header.last_modified_size);
+    offset += header.last_modified_size;
+    entry.body = data.substr(offset, header.body_size);
+    entry.is_fresh = (now_unix() < slot->expires_at);
+    return true;
+}
+
+void CURL_DiskCache::store(const std::string& url, std::string_view body, const CURL_CacheHeaders& headers)
+{
+    if (headers.no_store)
+    {
+        return;
+    }
+    const std::uint64_t url_hash = hash(url);
+    IndexSlot* slot = find_slot(url_hash, true/*for_insert*/);
+    assert(slot);
+    // invalidate first, so a crash or failed write in between leaves no
+    // dangling slot; tombstone keeps the probe chain through it intact
+    *slot = IndexSlot{};
+    slot->url_hash = kTombstone;
+
+    BodyHeader header{};
+    header.magic = kBodyMagic;
+    header.url_size = static_cast<std::uint32_t>(url.size());
+    header.etag_size = static_cast<std::uint32_t>(headers.etag.size());
+    header.last_modified_size = static_cast<std::uint32_t>(headers.last_modified.size());
+    header.body_size = body.size();
+
+    // write to temporary file and rename, readers never see partial file
+    const std::filesystem::path path = body_path(url_hash);
+    std::filesystem::path tmp_path = path;
+    tmp_path += ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            return;
+        }
+        (void)out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        (void)out.write(url.data(), static_cast<std::streamsize>(url.size()));
+        (void)out.write(headers.etag.data(), static_cast<std::streamsize>(headers.etag.size()));
+        (void)out.write(headers.last_modified.data(), static_cast<std::streamsize>(headers.last_modified.size()));
+        (void)out.write(body.data(), static_cast<std::streamsize>(body.size()));
+        if (!out)
+        {
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, path, ec);
+    if (ec)
+    {
+        return;
+    }
+    slot->body_size = body.size();
+    slot->expires_at = expires_at(headers);
+    slot->url_hash = url_hash;
+}
+
+void CURL_DiskCache::refresh(const std::string& url, const CURL_CacheHeaders& headers)
+{
+    if (IndexSlot* slot = find_slot(hash(url), false/*for_insert*/))
+    {
+        slot->expires_at = expires_at(headers);
+    }
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler(const CURL_DiskCacheOptions& cache_options);
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+    CURL_DiskCache _cache;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler(const CURL_DiskCacheOptions& cache_options)
+    : _cache{cache_options}
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+CURL_Async CURL_async_create(const CURL_DiskCacheOptions& cache_options)
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler(cache_options);
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+// response is either a view into mapped file or into owned string;
+// owned is non-null when the data can be moved out
+using CURL_OnResponse = std::function<void (std::string_view response, std::string* owned)>;
+
+struct CURL_DiskCachedRequest
+{
+    std::string url;
+    std::string response;
+    CURL_CacheHeaders headers;
+    curl_slist* conditional_headers = nullptr;
+    // stale entry, served without copy on 304
+    CURL_DiskCache::Entry stale;
+    CURL_OnResponse on_response;
+};
+
+static void CURL_AsyncGetImpl(CURL_Async curl_async
+    , const std::string& url
+    , CURL_OnResponse on_response)
+{
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(curl_async);
+    CURL_DiskCachedRequest* state = new CURL_DiskCachedRequest{};
+
+    // 0. fresh hit, no need to touch the network
+    const bool found = scheduler._cache.find(url, state->stale);
+    if (found && state->stale.is_fresh)
+    {
+        on_response(state->stale.body, nullptr);
+        delete state;
+        return;
+    }
+
+    // 1. setup curl easy handle
+    state->url = url;
+    state->on_response = std::move(on_response);
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, state->url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data and cache-related headers
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, &state->response);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_HEADERFUNCTION, CURL_OnHeaderCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_HEADERDATA, &state->headers);
+    assert(status == CURLE_OK);
+
+    // 3. stale entry: ask server to confirm it is still valid
+    if (found)
+    {
+        if (!state->stale.etag.empty())
+        {
+            const std::string header = "If-None-Match: " + std::string(state->stale.etag);
+            state->conditional_headers = curl_slist_append(state->conditional_headers, header.c_str());
+            assert(state->conditional_headers);
+        }
+        if (!state->stale.last_modified.empty())
+        {
+            const std::string header = "If-Modified-Since: " + std::string(state->stale.last_modified);
+            state->conditional_headers = curl_slist_append(state->conditional_headers, header.c_str());
+            assert(state->conditional_headers);
+        }
+        status = curl_easy_setopt(curl_easy, CURLOPT_HTTPHEADER, state->conditional_headers);
+        assert(status == CURLE_OK);
+    }
+
+    // 4. associate with multi handle/event loop
+    scheduler.add_request(curl_easy
+        , [&scheduler, state](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        curl_easy_cleanup(curl_easy_);
+        curl_slist_free_all(state->conditional_headers);
+        if (response_code == 304L)
+        {
+            assert(state->stale.file._data);
+            scheduler._cache.refresh(state->url, state->headers);
+            state->on_response(state->stale.body, nullptr);
+        }
+        else
+        {
+            assert(response_code == 200L);
+            // release the mapping before the file is replaced
+            state->stale.file.close();
+            scheduler._cache.store(state->url, state->response, state->headers);
+            state->on_response(state->response, &state->response);
+        }
+        delete state;
+    });
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    CURL_AsyncGetImpl(curl_async, url
+        , [user_data, callback](std::string_view response, std::string* owned)
+    {
+        callback(user_data, owned ? std::move(*owned) : std::string(response));
+    });
+}
+
+void CURL_async_get_view(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string_view response))
+{
+    CURL_AsyncGetImpl(curl_async, url
+        , [user_data, callback](std::string_view response, std::string*)
+    {
+        callback(user_data, response);
+    });
+}
+
+bool CURL_async_try_get_cached(CURL_Async curl_async
+    , const std::string& url
+    , std::string& response)
+{
+    CURL_DiskCache::Entry entry;
+    if (CURL_scheduler(curl_async)._cache.find(url, entry) && entry.is_fresh)
+    {
+        response = entry.body;
+        return true;
+    }
+    return false;
+}
+
+struct Co_Task
+{
+    struct promise_type;
+    using co_handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type
+    {
+        Co_Task get_return_object()
+        {
+            return Co_Task{co_handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+            // yeah, we return void. Nothing to do
+        }
+
+        void unhandled_exception()
+        {
+            // crash, no exceptions handling
+            assert(false);
+        }
+    };
+
+    Co_Task(co_handle coro)
+        : _coro{coro} {}
+    Co_Task(Co_Task&& rhs) noexcept
+        : _coro{std::exchange(rhs._coro, {})} { }
+    Co_Task(const Co_Task&) = delete;
+    ~Co_Task() noexcept
+    {
+        if (_coro)
+        {
+            _coro.destroy();
+        }
+    }
+
+    void resume()
+    {
+        assert(_coro);
+        assert(!_coro.done());
+        _coro.resume();
+    }
+
+    bool is_in_progress() const
+    {
+        assert(_coro);
+        return !_coro.done();
+    }
+
+    co_handle _coro;
+};
+
+struct Co_CurlAsync
+{
+    CURL_Async _curl_async{};
+    std::string _url;
+    std::coroutine_handle<> _coro;
+    std::string _response;
+
+    bool await_ready()
+    { // 1. fresh cache hit: no suspension at all
+        return CURL_async_try_get_cached(_curl_async, _url, _response);
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    { // 2. remember coroutine handle, start request, resume on finish:
+        _coro = coro;
+
+        CURL_async_get(_curl_async, _url, this
+            , [](void* user_data, std::string response)
+        {
+            Co_CurlAsync& self = *static_cast<Co_CurlAsync*>(user_data);
+            self._response = std::move(response);
+            self._coro.resume();
+        });
+    }
+
+    std::string await_resume()
+    { // 3. after resume (or no suspend), return response:
+        return std::move(_response);
+    }
+};
+
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url)
+{
+    Co_CurlAsync awaiter;
+    awaiter._curl_async = curl_async;
+    awaiter._url = url;
+    return awaiter;
+}
+
+static Co_Task coro_main(CURL_Async curl_async)
+{
+    // first run: miss; next runs (within max-age): fresh hit from disk
+    const std::string response = co_await CURL_await_get(
+        curl_async, "localhost:5001/file1.txt");
+    std::println("coro_main response: '{}'", response);
+    co_return;
+}
+
+int main()
+{
+    CURL_DiskCacheOptions cache_options;
+    cache_options.directory = "curl_cache";
+    // http.server sends Last-Modified, but no Cache-Control;
+    // run twice within a minute to see disk hits
+    cache_options.default_max_age = std::chrono::seconds{60};
+    CURL_Async curl_async = CURL_async_create(cache_options);
+
+    Co_Task task = coro_main(curl_async);
+    task.resume();
+    while (task.is_in_progress())
+    {
+        CURL_async_tick(curl_async);
+    }
+
+    bool done = false;
+    CURL_async_get_view(curl_async, "localhost:5001/file1.txt", &done
+        , [](void* user_data, std::string_view response)
+    {
+        std::println("async view response: '{}'", response);
+        *static_cast<bool*>(user_data) = true;
+    });
+    while (!done)
+    {
+        CURL_async_tick(curl_async);
+    }
+
+    CURL_async_destroy(curl_async);
+}
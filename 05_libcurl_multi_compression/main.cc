@@ -0,0 +1,411 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include <cctype>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// compressed vs decompressed traffic
+struct CURL_EncodingStats
+{
+    std::uint64_t responses = 0;
+    // responses with Content-Encoding (gzip, deflate, br, zstd)
+    std::uint64_t encoded_responses = 0;
+    // body bytes as they were received, before decoding
+    std::uint64_t wire_bytes = 0;
+    // body bytes delivered to the user, after decoding
+    std::uint64_t decoded_bytes = 0;
+};
+
+// our blocking API
+std::string CURL_get(const std::string& url, CURL_EncodingStats* stats = nullptr);
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+CURL_EncodingStats CURL_async_encoding_stats(CURL_Async curl_async);
+
+// main async callback API
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+// streaming API: on_chunk is invoked with already decoded data
+// as soon as it arrives, on_finish once transfer is complete
+void CURL_async_get_stream(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*on_chunk)(void* user_data, std::string_view chunk)
+    , void (*on_finish)(void* user_data));
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+static bool CURL_IStartsWith(std::string_view str, std::string_view prefix)
+{
+    if (str.size() < prefix.size())
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < prefix.size(); ++i)
+    {
+        if (std::tolower(static_cast<unsigned char>(str[i]))
+            != std::tolower(static_cast<unsigned char>(prefix[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t CURL_OnHeaderCallback(char* buffer, size_t size, size_t nitems, void* data)
+{
+    bool& is_encoded = *static_cast<bool*>(data);
+    const std::string_view line(buffer, size * nitems);
+    if (line.starts_with("HTTP/"))
+    {   // new status line (redirect, 100-continue)
+        is_encoded = false;
+    }
+    else if (CURL_IStartsWith(line, "Content-Encoding:"))
+    {
+        is_encoded = true;
+    }
+    return (size * nitems);
+}
+
+// ask for every encoding libcurl was built with, decoding happens
+// incrementally inside libcurl, before our write callback
+static void CURL_SetupEncoding(CURL* curl_easy, bool* is_encoded)
+{
+    // empty string: all built-in encodings (gzip, deflate, br, zstd)
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_ACCEPT_ENCODING, "");
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_HEADERFUNCTION, CURL_OnHeaderCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_HEADERDATA, is_encoded);
+    assert(status == CURLE_OK);
+}
+
+static void CURL_UpdateStats(CURL* curl_easy, bool is_encoded, CURL_EncodingStats& stats)
+{
+    // CURLINFO_SIZE_DOWNLOAD_T counts raw body bytes, before decoding
+    curl_off_t wire_bytes = 0;
+    const CURLcode status = curl_easy_getinfo(curl_easy, CURLINFO_SIZE_DOWNLOAD_T, &wire_bytes);
+    assert(status == CURLE_OK);
+    stats.responses += 1;
+    stats.encoded_responses += (is_encoded ? 1 : 0);
+    stats.wire_bytes += static_cast<std::uint64_t>(wire_bytes);
+}
+
+std::string CURL_get(const std::string& url, CURL_EncodingStats* stats /*= nullptr*/)
+{
+    CURL* curl = curl_easy_init();
+    assert(curl);
+
+    CURLcode status = curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+    bool is_encoded = false;
+    CURL_SetupEncoding(curl, &is_encoded);
+
+    std::string response;
+    status = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    assert(status == CURLE_OK);
+
+    status = curl_easy_perform(curl);
+    assert(status == CURLE_OK);
+
+    long response_code = -1;
+    status = curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+    assert(status == CURLE_OK);
+    assert(response_code == 200L);
+
+    if (stats)
+    {
+        CURL_UpdateStats(curl, is_encoded, *stats);
+        stats->decoded_bytes += response.size();
+    }
+    curl_easy_cleanup(curl);
+    return response;
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+    CURL_EncodingStats _stats;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+CURL_EncodingStats CURL_async_encoding_stats(CURL_Async curl_async)
+{
+    return CURL_scheduler(curl_async)._stats;
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    struct State
+    {
+        std::string response;
+        bool is_encoded = false;
+    };
+
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+    State* state = new State{};
+    CURL_SetupEncoding(curl_easy, &state->is_encoded);
+
+    // 2. write (already decoded) response data to separate std::string
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, &state->response);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(curl_async);
+    scheduler.add_request(curl_easy
+        , [&scheduler, state, user_data, callback](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        CURL_UpdateStats(curl_easy_, state->is_encoded, scheduler._stats);
+        scheduler._stats.decoded_bytes += state->response.size();
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(state->response);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+}
+
+struct CURL_StreamState
+{
+    void* user_data = nullptr;
+    void (*on_chunk)(void* user_data, std::string_view chunk) = nullptr;
+    std::uint64_t decoded_bytes = 0;
+    bool is_encoded = false;
+};
+
+static size_t CURL_OnStreamWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    CURL_StreamState& state = *static_cast<CURL_StreamState*>(data);
+    const std::string_view chunk(static_cast<const char*>(ptr), size * nmemb);
+    state.decoded_bytes += chunk.size();
+    state.on_chunk(state.user_data, chunk);
+    return (size * nmemb);
+}
+
+void CURL_async_get_stream(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*on_chunk)(void* user_data, std::string_view chunk)
+    , void (*on_finish)(void* user_data))
+{
+    assert(on_chunk);
+    assert(on_finish);
+
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+    CURL_StreamState* state = new CURL_StreamState{};
+    state->user_data = user_data;
+    state->on_chunk = on_chunk;
+    CURL_SetupEncoding(curl_easy, &state->is_encoded);
+
+    // 2. forward decoded chunks to the user, nothing is accumulated
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnStreamWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(curl_async);
+    scheduler.add_request(curl_easy
+        , [&scheduler, state, user_data, on_finish](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        CURL_UpdateStats(curl_easy_, state->is_encoded, scheduler._stats);
+        scheduler._stats.decoded_bytes += state->decoded_bytes;
+        curl_easy_cleanup(curl_easy_);
+        delete state;
+        on_finish(user_data);
+    });
+}
+
+static void print_stats(const char* title, const CURL_EncodingStats& stats)
+{
+    std::println("{}: {} responses ({} encoded), wire {} bytes, decoded {} bytes"
+        , title
+        , stats.responses
+        , stats.encoded_responses
+        , stats.wire_bytes
+        , stats.decoded_bytes);
+}
+
+int main()
+{
+    // see serve_compressed.py: serves data.json pre-compressed
+    const char* url = "localhost:5001/data.json";
+
+    CURL_EncodingStats blocking_stats;
+    const std::string r = CURL_get(url, &blocking_stats);
+    std::println("CURL_get(data.json): {} bytes", r.size());
+    print_stats("blocking", blocking_stats);
+
+    struct State
+    {
+        std::size_t response_size = 0;
+        std::size_t chunks = 0;
+        std::size_t streamed_size = 0;
+        int count = 0;
+    };
+    CURL_Async curl_async = CURL_async_create();
+    State state;
+    CURL_async_get(curl_async, url, &state
+        , [](void* user_data, std::string response)
+    {
+        State& state_ = *static_cast<State*>(user_data);
+        state_.response_size = response.size();
+        state_.count += 1;
+    });
+    CURL_async_get_stream(curl_async, url, &state
+        , [](void* user_data, std::string_view chunk)
+    {
+        State& state_ = *static_cast<State*>(user_data);
+        state_.chunks += 1;
+        state_.streamed_size += chunk.size();
+    }
+        , [](void* user_data)
+    {
+        State& state_ = *static_cast<State*>(user_data);
+        state_.count += 1;
+    });
+    while (state.count != 2)
+    {
+        CURL_async_tick(curl_async);
+    }
+    std::println("async response: {} bytes; streamed {} bytes in {} chunks"
+        , state.response_size, state.streamed_size, state.chunks);
+    print_stats("async", CURL_async_encoding_stats(curl_async));
+    CURL_async_destroy(curl_async);
+}
@@ -0,0 +1 @@
+python serve_compressed.py
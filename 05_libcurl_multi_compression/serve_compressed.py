@@ -0,0 +1,59 @@
+# Static file server that honors Accept-Encoding with pre-compressed
+# bodies (gzip, deflate), compressed once and kept in memory.
+# Same port and directory as `python -m http.server 5001`, plus
+# generated /data.json - repetitive JSON payload that compresses well.
+import gzip
+import http.server
+import json
+import os
+import zlib
+
+PORT = 5001
+
+SAMPLE_JSON = json.dumps(
+    [{"id": i, "name": f"item {i}", "tags": ["alpha", "beta", "gamma"]}
+     for i in range(2000)], indent=2).encode("utf-8")
+
+class PrecompressedHandler(http.server.SimpleHTTPRequestHandler):
+    cache = {}
+
+    def load(self):
+        if self.path == "/data.json":
+            return SAMPLE_JSON
+        path = self.translate_path(self.path)
+        if not os.path.isfile(path):
+            return None
+        with open(path, "rb") as f:
+            return f.read()
+
+    def encoded(self, encoding):
+        key = (self.path, encoding)
+        if key not in self.cache:
+            data = self.load()
+            if data is None:
+                return None
+            if encoding == "gzip":
+                self.cache[key] = gzip.compress(data, 9)
+            elif encoding == "deflate":
+                self.cache[key] = zlib.compress(data, 9)
+            else:
+                self.cache[key] = data
+        return self.cache[key]
+
+    def do_GET(self):
+        accept = self.headers.get("Accept-Encoding", "")
+        encoding = next((e for e in ("gzip", "deflate") if e in accept), "identity")
+        body = self.encoded(encoding)
+        if body is None:
+            return super().do_GET()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/json" if self.path.endswith(".json") else "text/plain")
+        if encoding != "identity":
+            self.send_header("Content-Encoding", encoding)
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+if __name__ == "__main__":
+    os.chdir(os.path.dirname(os.path.abspath(__file__)))
+    http.server.ThreadingHTTPServer(("", PORT), PrecompressedHandler).serve_forever()
@@ -0,0 +1,534 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <deque>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <bit>
+#include <algorithm>
+#include <cstdint>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+struct CURL_AsyncOptions
+{
+    // transfers handed to libcurl at once; the rest wait in our own
+    // admission queue (measured as "queue" phase). 0 means unlimited
+    std::size_t max_in_flight = 0;
+};
+
+// where time of a single request goes, in order;
+// derived from CURLINFO_*_TIME_T, all in microseconds
+enum class CURL_Phase
+{
+    Queue,    // CURL_async_get() -> curl_multi_add_handle()
+    Dns,      // NAMELOOKUP
+    Connect,  // CONNECT - NAMELOOKUP
+    Tls,      // APPCONNECT - CONNECT, 0 for plain http
+    Server,   // STARTTRANSFER - max(CONNECT, APPCONNECT), time to first byte
+    Transfer, // TOTAL - STARTTRANSFER
+    Total,    // Queue + TOTAL
+    Count_,
+};
+
+static const char* CURL_PhaseName(CURL_Phase phase)
+{
+    switch (phase)
+    {
+    case CURL_Phase::Queue:    return "queue";
+    case CURL_Phase::Dns:      return "dns";
+    case CURL_Phase::Connect:  return "connect";
+    case CURL_Phase::Tls:      return "tls";
+    case CURL_Phase::Server:   return "server";
+    case CURL_Phase::Transfer: return "transfer";
+    case CURL_Phase::Total:    return "total";
+    case CURL_Phase::Count_:   break;
+    }
+    return "?";
+}
+
+constexpr std::size_t kCURL_PhasesCount = static_cast<std::size_t>(CURL_Phase::Count_);
+
+struct CURL_PhaseSnapshot
+{
+    std::uint64_t count = 0;
+    std::uint64_t mean_us = 0;
+    std::uint64_t p50_us = 0;
+    std::uint64_t p90_us = 0;
+    std::uint64_t p99_us = 0;
+    std::uint64_t max_us = 0;
+};
+
+struct CURL_HostTimingSnapshot
+{
+    std::string host; // host:port
+    std::array<CURL_PhaseSnapshot, kCURL_PhasesCount> phases{};
+};
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create(const CURL_AsyncOptions& options = {});
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+
+// safe to call from any thread, concurrently with tick()
+std::vector<CURL_HostTimingSnapshot> CURL_async_timing_snapshot(CURL_Async curl_async);
+
+// main async callback API
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+// HdrHistogram-like log-linear buckets: every power of 2 is split into
+// 2^kSubBucketBits linear sub-buckets, so relative error is ~3%
+// for any value, with fixed memory and O(1) record.
+// Single writer (the tick() thread), any number of readers:
+// counters are relaxed atomics, no locks on either side
+struct CURL_LatencyHistogram
+{
+    static constexpr unsigned kSubBucketBits = 5;
+    static constexpr std::uint64_t kSubBuckets = (std::uint64_t{1} << kSubBucketBits);
+    // up to 2^36 us (~19 hours); bigger values are clamped
+    static constexpr unsigned kMaxValueBits = 36;
+    static constexpr std::size_t kBucketsCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+    static std::size_t bucket_index(std::uint64_t value)
+    {
+        value = std::min(value, (std::uint64_t{1} << kMaxValueBits) - 1);
+        if (value < kSubBuckets)
+        {
+            return static_cast<std::size_t>(value);
+        }
+        const unsigned msb = static_cast<unsigned>(std::bit_width(value)) - 1;
+        const unsigned shift = msb - kSubBucketBits;
+        const std::uint64_t sub = (value >> shift) - kSubBuckets;
+        return static_cast<std::size_t>(((shift + 1) * kSubBuckets) + sub);
+    }
+
+    // upper bound of values that land into the bucket
+    static std::uint64_t bucket_value(std::size_t index)
+    {
+        const std::uint64_t group = index / kSubBuckets;
+        const std::uint64_t sub = index % kSubBuckets;
+        if (group == 0)
+        {
+            return sub;
+        }
+        const std::uint64_t shift = group - 1;
+        return (((kSubBuckets + sub + 1) << shift) - 1);
+    }
+
+    void record(std::uint64_t value)
+    {
+        _buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+        if (value > _max.load(std::memory_order_relaxed))
+        {   // single writer, no need for CAS loop
+            _max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    CURL_PhaseSnapshot snapshot() const;
+
+    std::array<std::atomic<std::uint64_t>, kBucketsCount> _buckets{};
+    std::atomic<std::uint64_t> _count{0};
+    std::atomic<std::uint64_t> _sum{0};
+    std::atomic<std::uint64_t> _max{0};
+};
+
+CURL_PhaseSnapshot CURL_LatencyHistogram::snapshot() const
+{
+    // copy first: writer may continue to record while we read
+    std::array<std::uint64_t, kBucketsCount> buckets;
+    std::uint64_t count = 0;
+    for (std::size_t i = 0; i < kBucketsCount; ++i)
+    {
+        buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+        count += buckets[i];
+    }
+
+    CURL_PhaseSnapshot snapshot;
+    snapshot.count = count;
+    if (count == 0)
+    {
+        return snapshot;
+    }
+    snapshot.mean_us = _sum.load(std::memory_order_relaxed)
+        / std::max<std::uint64_t>(_count.load(std::memory_order_relaxed), 1);
+    snapshot.max_us = _max.load(std::memory_order_relaxed);
+
+    const auto percentile = [&](double p)
+    {
+        const std::uint64_t rank = std::max<std::uint64_t>(1
+            , static_cast<std::uint64_t>(p * static_cast<double>(count) + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBucketsCount; ++i)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+            {
+                return std::min(bucket_value(i), snapshot.max_us);
+            }
+        }
+        return snapshot.max_us;
+    };
+    snapshot.p50_us = percentile(0.50);
+    snapshot.p90_us = percentile(0.90);
+    snapshot.p99_us = percentile(0.99);
+    return snapshot;
+}
+
+struct CURL_HostTimings
+{
+    // written once by tick() thread before _published is set
+    std::string host;
+    std::array<CURL_LatencyHistogram, kCURL_PhasesCount> phases;
+};
+
+// fixed-capacity, append-only table: readers never see rehashing
+// or reallocation, only already published slots
+struct CURL_TimingTable
+{
+    static constexpr std::size_t kMaxHosts = 16;
+    // name of the last slot, shared by hosts that didn't get their own
+    static constexpr std::string_view kOtherHosts = "(other)";
+
+    CURL_HostTimings& host_timings(std::string_view host);
+
+    std::array<CURL_HostTimings, kMaxHosts> _hosts;
+    std::atomic<std::size_t> _published{0};
+};
+
+CURL_HostTimings& CURL_TimingTable::host_timings(std::string_view host)
+{
+    // tick() thread is the only writer, relaxed is enough to read own writes
+    const std::size_t published = _published.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < published; ++i)
+    {
+        if (_hosts[i].host == host)
+        {
+            return _hosts[i];
+        }
+    }
+    if (published == kMaxHosts)
+    {   // too many hosts; the rest share the "(other)" slot
+        return _hosts[kMaxHosts - 1];
+    }
+    CURL_HostTimings& timings = _hosts[published];
+    // at most kMaxHosts - 1 named hosts, the last slot is reserved
+    timings.host = (published == (kMaxHosts - 1)) ? kOtherHosts : host;
+    _published.store(published + 1, std::memory_order_release);
+    return timings;
+}
+
+static std::string CURL_HostOf(CURL* curl_easy)
+{
+    const char* effective_url = nullptr;
+    const CURLcode status = curl_easy_getinfo(curl_easy, CURLINFO_EFFECTIVE_URL, &effective_url);
+    assert(status == CURLE_OK);
+    assert(effective_url);
+
+    std::string host = "unknown";
+    CURLU* url = curl_url();
+    assert(url);
+    if (curl_url_set(url, CURLUPART_URL, effective_url, CURLU_DEFAULT_SCHEME) == CURLUE_OK)
+    {
+        char* name = nullptr;
+        if (curl_url_get(url, CURLUPART_HOST, &name, 0) == CURLUE_OK)
+        {
+            host = name;
+            curl_free(name);
+        }
+        char* port = nullptr;
+        if (curl_url_get(url, CURLUPART_PORT, &port, CURLU_DEFAULT_PORT) == CURLUE_OK)
+        {
+            host += ':';
+            host += port;
+            curl_free(port);
+        }
+    }
+    curl_url_cleanup(url);
+    return host;
+}
+
+static std::uint64_t CURL_InfoTime(CURL* curl_easy, CURLINFO info)
+{
+    curl_off_t time_us = 0;
+    const CURLcode status = curl_easy_getinfo(curl_easy, info, &time_us);
+    assert(status == CURLE_OK);
+    return static_cast<std::uint64_t>(std::max<curl_off_t>(time_us, 0));
+}
+
+struct CURL_AsyncScheduler
+{
+    using Clock = std::chrono::steady_clock;
+
+    CURL_AsyncScheduler(const CURL_AsyncOptions& options);
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+
+    void admit(CURL* curl_easy);
+    void record_timings(CURL* curl_easy, Clock::duration queue_time);
+
+    struct Request
+    {
+        Callback on_finish;
+        Clock::time_point submitted_at;
+        Clock::time_point admitted_at;
+    };
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    CURL_AsyncOptions _options;
+    std::unordered_map<CURL*, Request> _curl_to_request;
+    // submitted, but not yet given to libcurl
+    std::deque<CURL*> _pending;
+    std::size_t _in_flight = 0;
+    CURL_TimingTable _timings;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler(const CURL_AsyncOptions& options)
+    : _options{options}
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_request.find(curl_easy);
+        assert(it != _curl_to_request.end());
+        Callback callback = std::move(it->second.on_finish);
+        assert(callback);
+        record_timings(curl_easy, it->second.admitted_at - it->second.submitted_at);
+        (void)_curl_to_request.erase(it);
+        --_in_flight;
+        // free slot: next queued request goes to libcurl
+        if (!_pending.empty())
+        {
+            CURL* next = _pending.front();
+            _pending.pop_front();
+            admit(next);
+        }
+        callback(curl_easy);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_request.contains(curl_easy));
+    Request& request = _curl_to_request[curl_easy];
+    request.on_finish = std::move(on_finish);
+    request.submitted_at = Clock::now();
+    if ((_options.max_in_flight > 0) && (_in_flight >= _options.max_in_flight))
+    {
+        _pending.push_back(curl_easy);
+        return;
+    }
+    admit(curl_easy);
+}
+
+void CURL_AsyncScheduler::admit(CURL* curl_easy)
+{
+    auto it = _curl_to_request.find(curl_easy);
+    assert(it != _curl_to_request.end());
+    it->second.admitted_at = Clock::now();
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    ++_in_flight;
+}
+
+void CURL_AsyncScheduler::record_timings(CURL* curl_easy, Clock::duration queue_time)
+{
+    // all CURLINFO_*_TIME_T are cumulative, since the start of the transfer
+    const std::uint64_t dns = CURL_InfoTime(curl_easy, CURLINFO_NAMELOOKUP_TIME_T);
+    const std::uint64_t connect = std::max(CURL_InfoTime(curl_easy, CURLINFO_CONNECT_TIME_T), dns);
+    // 0 if there was no TLS handshake (or connection was reused)
+    const std::uint64_t app_connect = std::max(CURL_InfoTime(curl_easy, CURLINFO_APPCONNECT_TIME_T), connect);
+    const std::uint64_t first_byte = std::max(CURL_InfoTime(curl_easy, CURLINFO_STARTTRANSFER_TIME_T), app_connect);
+    const std::uint64_t total = std::max(CURL_InfoTime(curl_easy, CURLINFO_TOTAL_TIME_T), first_byte);
+    const std::uint64_t queue = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(queue_time).count());
+
+    CURL_HostTimings& timings = _timings.host_timings(CURL_HostOf(curl_easy));
+    const auto record = [&](CURL_Phase phase, std::uint64_t value_us)
+    {
+        timings.phases[static_cast<std::size_t>(phase)].record(value_us);
+    };
+    record(CURL_Phase::Queue, queue);
+    record(CURL_Phase::Dns, dns);
+    record(CURL_Phase::Connect, connect - dns);
+    record(CURL_Phase::Tls, app_connect - connect);
+    record(CURL_Phase::Server, first_byte - app_connect);
+    record(CURL_Phase::Transfer, total - first_byte);
+    record(CURL_Phase::Total, queue + total);
+}
+
+CURL_Async CURL_async_create(const CURL_AsyncOptions& options /*= {}*/)
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler(options);
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+std::vector<CURL_HostTimingSnapshot> CURL_async_timing_snapshot(CURL_Async curl_async)
+{
+    const CURL_TimingTable& table = CURL_scheduler(curl_async)._timings;
+    // acquire: pairs with release in host_timings(), host name is visible
+    const std::size_t published = table._published.load(std::memory_order_acquire);
+    std::vector<CURL_HostTimingSnapshot> snapshots(published);
+    for (std::size_t i = 0; i < published; ++i)
+    {
+        snapshots[i].host = table._hosts[i].host;
+        for (std::size_t phase = 0; phase < kCURL_PhasesCount; ++phase)
+        {
+            snapshots[i].phases[phase] = table._hosts[i].phases[phase].snapshot();
+        }
+    }
+    return snapshots;
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to separate std::string
+    std::string* state = new std::string{};
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop;
+    // timings are collected by the scheduler before the callback
+    CURL_scheduler(curl_async).add_request(curl_easy
+        , [state, user_data, callback](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(*state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+}
+
+static void print_timings(const std::vector<CURL_HostTimingSnapshot>& snapshots)
+{
+    for (const CURL_HostTimingSnapshot& host : snapshots)
+    {
+        std::println("{}:", host.host);
+        for (std::size_t phase = 0; phase < kCURL_PhasesCount; ++phase)
+        {
+            const CURL_PhaseSnapshot& s = host.phases[phase];
+            std::println("  {:>8}: n {}, mean {} us, p50 {} us, p90 {} us, p99 {} us, max {} us"
+                , CURL_PhaseName(static_cast<CURL_Phase>(phase))
+                , s.count, s.mean_us, s.p50_us, s.p90_us, s.p99_us, s.max_us);
+        }
+    }
+}
+
+int main()
+{
+    // 4 transfers at once, the rest wait in admission queue
+    CURL_AsyncOptions options;
+    options.max_in_flight = 4;
+    CURL_Async curl_async = CURL_async_create(options);
+
+    int done = 0;
+    const int count = 32;
+    for (int i = 0; i < count; ++i)
+    {
+        CURL_async_get(curl_async, "localhost:5001/file1.txt", &done
+            , [](void* user_data, std::string response)
+        {
+            assert(response == "content 1");
+            *static_cast<int*>(user_data) += 1;
+        });
+    }
+    while (done != count)
+    {
+        CURL_async_tick(curl_async);
+    }
+    print_timings(CURL_async_timing_snapshot(curl_async));
+    CURL_async_destroy(curl_async);
+}
@@ -0,0 +1,505 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <coroutine>
+#include <utility>
+#include <cstdint>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// opt-in tracing, Chrome trace event format;
+// open the dump with ui.perfetto.dev or chrome://tracing
+void CURL_trace_enable(bool enable);
+// only after CURL_trace_enable(false), once traced threads stopped
+// recording: rings are read without synchronizing with writers
+bool CURL_trace_dump(const std::string& file_path);
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+
+// main async callback API
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+// coro await
+struct Co_CurlAsync;
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+using CURL_TraceClock = std::chrono::steady_clock;
+
+struct CURL_TraceEvent
+{
+    // static string, never copied
+    const char* name = nullptr;
+    // Chrome trace phase: 'B'/'E' duration, 'b'/'e' async, 'i' instant
+    char phase = 0;
+    std::uint64_t id = 0;
+    CURL_TraceClock::time_point time;
+};
+
+// one per thread, single writer; oldest events are overwritten
+struct CURL_TraceRing
+{
+    static constexpr std::size_t kCapacity = 16 * 1024; // power of 2
+
+    void push(const CURL_TraceEvent& event)
+    {
+        _events[_written & (kCapacity - 1)] = event;
+        // release: dump() sees complete events up to _written
+        _written.store(_written.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    std::array<CURL_TraceEvent, kCapacity> _events{};
+    std::atomic<std::uint64_t> _written{0};
+    std::uint32_t _thread_id = 0;
+};
+
+struct CURL_Tracer
+{
+    CURL_TraceRing& this_thread_ring();
+
+    std::atomic<bool> _enabled{false};
+    CURL_TraceClock::time_point _start = CURL_TraceClock::now();
+    // registration happens once per thread, the only lock
+    std::mutex _rings_mutex;
+    // shared: ring outlives its thread until dumped
+    std::vector<std::shared_ptr<CURL_TraceRing>> _rings;
+};
+
+static CURL_Tracer g_CURL_tracer;
+
+CURL_TraceRing& CURL_Tracer::this_thread_ring()
+{
+    thread_local CURL_TraceRing* ring = nullptr;
+    if (!ring)
+    {
+        std::shared_ptr<CURL_TraceRing> new_ring = std::make_shared<CURL_TraceRing>();
+        std::lock_guard lock{_rings_mutex};
+        new_ring->_thread_id = static_cast<std::uint32_t>(_rings.size() + 1);
+        ring = new_ring.get();
+        _rings.push_back(std::move(new_ring));
+    }
+    return *ring;
+}
+
+static void CURL_TraceRecord(const char* name, char phase, std::uint64_t id
+    , CURL_TraceClock::time_point time = CURL_TraceClock::now())
+{
+    g_CURL_tracer.this_thread_ring().push(CURL_TraceEvent{name, phase, id, time});
+}
+
+// the only cost when tracing is disabled: one relaxed load + branch
+static bool CURL_TraceIsOn()
+{
+    return g_CURL_tracer._enabled.load(std::memory_order_relaxed);
+}
+
+static void CURL_Trace(const char* name, char phase, std::uint64_t id = 0)
+{
+    if (CURL_TraceIsOn()) [[unlikely]]
+    {
+        CURL_TraceRecord(name, phase, id);
+    }
+}
+
+void CURL_trace_enable(bool enable)
+{
+    g_CURL_tracer._enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool CURL_trace_dump(const std::string& file_path)
+{
+    // otherwise slots being read may be overwritten concurrently
+    assert(!CURL_TraceIsOn());
+    std::ofstream out{file_path, std::ios::binary | std::ios::trunc};
+    if (!out)
+    {
+        return false;
+    }
+    std::lock_guard lock{g_CURL_tracer._rings_mutex};
+    // fixed, ns resolution: default 6 significant digits lose us after ~1s
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const std::shared_ptr<CURL_TraceRing>& ring : g_CURL_tracer._rings)
+    {
+        // acquire: pairs with release in push()
+        const std::uint64_t written = ring->_written.load(std::memory_order_acquire);
+        const std::uint64_t begin = (written > CURL_TraceRing::kCapacity)
+            ? (written - CURL_TraceRing::kCapacity)
+            : 0;
+        for (std::uint64_t i = begin; i < written; ++i)
+        {
+            const CURL_TraceEvent& event = ring->_events[i & (CURL_TraceRing::kCapacity - 1)];
+            const auto ts = std::chrono::duration<double, std::micro>(event.time - g_CURL_tracer._start);
+            out << (first ? "" : ",\n")
+                << "{\"name\":\"" << event.name
+                << "\",\"cat\":\"curl\",\"ph\":\"" << event.phase
+                << "\",\"ts\":" << ts.count()
+                << ",\"pid\":1,\"tid\":" << ring->_thread_id;
+            if ((event.phase == 'b') || (event.phase == 'e'))
+            {
+                out << ",\"id\":" << event.id;
+            }
+            else if (event.phase == 'i')
+            {
+                out << ",\"s\":\"t\",\"args\":{\"id\":" << event.id << "}";
+            }
+            out << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    return bool(out);
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+
+    struct Request
+    {
+        Callback on_finish;
+        // trace only: async event id and curl_multi_add_handle() time
+        std::uint64_t trace_id = 0;
+        CURL_TraceClock::time_point added_at;
+    };
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Request> _curl_to_request;
+    std::uint64_t _next_trace_id = 1;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+// connect and first byte happen inside libcurl, no hook to observe them;
+// reconstruct from CURLINFO_*_TIME_T relative to curl_multi_add_handle()
+static void CURL_TraceTransferMilestones(CURL* curl_easy, const CURL_AsyncScheduler::Request& request)
+{
+    const auto at = [&](CURLINFO info)
+    {
+        curl_off_t time_us = 0;
+        const CURLcode status = curl_easy_getinfo(curl_easy, info, &time_us);
+        assert(status == CURLE_OK);
+        return request.added_at + std::chrono::microseconds{time_us};
+    };
+    CURL_TraceRecord("connect", 'i', request.trace_id, at(CURLINFO_CONNECT_TIME_T));
+    CURL_TraceRecord("first byte", 'i', request.trace_id, at(CURLINFO_STARTTRANSFER_TIME_T));
+    CURL_TraceRecord("request", 'e', request.trace_id, at(CURLINFO_TOTAL_TIME_T));
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_request.find(curl_easy);
+        assert(it != _curl_to_request.end());
+        Callback callback = std::move(it->second.on_finish);
+        assert(callback);
+        // traced only if tracing was on at submit time
+        if (it->second.trace_id != 0) [[unlikely]]
+        {
+            CURL_TraceTransferMilestones(curl_easy, it->second);
+        }
+        (void)_curl_to_request.erase(it);
+        CURL_Trace("callback", 'B');
+        callback(curl_easy);
+        CURL_Trace("callback", 'E');
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_request.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    Request& request = _curl_to_request[curl_easy];
+    request.on_finish = std::move(on_finish);
+    if (CURL_TraceIsOn()) [[unlikely]]
+    {
+        request.trace_id = _next_trace_id++;
+        request.added_at = CURL_TraceClock::now();
+        CURL_TraceRecord("submit", 'i', request.trace_id, request.added_at);
+        CURL_TraceRecord("request", 'b', request.trace_id, request.added_at);
+    }
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_Trace("tick", 'B');
+    CURL_scheduler(curl_async).tick();
+    CURL_Trace("tick", 'E');
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to separate std::string
+    std::string* state = new std::string{};
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    CURL_scheduler(curl_async).add_request(curl_easy
+        , [state, user_data, callback](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(*state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+}
+
+struct Co_Task
+{
+    struct promise_type;
+    using co_handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type
+    {
+        Co_Task get_return_object()
+        {
+            return Co_Task{co_handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+            // yeah, we return void. Nothing to do
+        }
+
+        void unhandled_exception()
+        {
+            // crash, no exceptions handling
+            assert(false);
+        }
+    };
+
+    Co_Task(co_handle coro)
+        : _coro{coro} {}
+    Co_Task(Co_Task&& rhs) noexcept
+        : _coro{std::exchange(rhs._coro, {})} { }
+    Co_Task(const Co_Task&) = delete;
+    ~Co_Task() noexcept
+    {
+        if (_coro)
+        {
+            _coro.destroy();
+        }
+    }
+
+    void resume()
+    {
+        assert(_coro);
+        assert(!_coro.done());
+        _coro.resume();
+    }
+
+    bool is_in_progress() const
+    {
+        assert(_coro);
+        return !_coro.done();
+    }
+
+    co_handle _coro;
+};
+
+struct Co_CurlAsync
+{
+    CURL_Async _curl_async{};
+    std::string _url;
+    std::coroutine_handle<> _coro;
+    std::string _response;
+
+    // coroutine frame address identifies suspension in the trace
+    std::uint64_t trace_id() const
+    {
+        return reinterpret_cast<std::uintptr_t>(_coro.address());
+    }
+
+    bool await_ready()
+    { // 1. CURL_async_get() is not yet started, force coroutine suspend:
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    { // 2. remember coroutine handle, start request, resume on finish:
+        _coro = coro;
+        CURL_Trace("suspended", 'b', trace_id());
+
+        CURL_async_get(_curl_async, _url, this
+            , [](void* user_data, std::string response)
+        {
+            Co_CurlAsync& self = *static_cast<Co_CurlAsync*>(user_data);
+            self._response = std::move(response);
+            CURL_Trace("suspended", 'e', self.trace_id());
+            // note: `self` lives in the coroutine frame
+            // and may be gone once resume() returns
+            CURL_Trace("resume", 'B');
+            self._coro.resume();
+            CURL_Trace("resume", 'E');
+        });
+    }
+
+    std::string await_resume()
+    { // 3. after resume, return response:
+        return std::move(_response);
+    }
+};
+
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url)
+{
+    Co_CurlAsync awaiter;
+    awaiter._curl_async = curl_async;
+    awaiter._url = url;
+    return awaiter;
+}
+
+static Co_Task coro_main(CURL_Async curl_async)
+{
+    const std::string r1 = co_await CURL_await_get(
+        curl_async, "localhost:5001/file1.txt");
+    const std::string r2 = co_await CURL_await_get(
+        curl_async, "localhost:5001/file1.txt");
+    std::println("coro_main responses: '{}', '{}'", r1, r2);
+    co_return;
+}
+
+int main()
+{
+    CURL_trace_enable(true);
+
+    CURL_Async curl_async = CURL_async_create();
+    Co_Task task = coro_main(curl_async);
+    task.resume();
+    // plain callback request, in parallel with the coroutine
+    bool done = false;
+    CURL_async_get(curl_async, "localhost:5001/file1.txt", &done
+        , [](void* user_data, std::string response)
+    {
+        std::println("async response: '{}'", response);
+        *static_cast<bool*>(user_data) = true;
+    });
+    while (task.is_in_progress() || !done)
+    {
+        CURL_async_tick(curl_async);
+        // keep the trace readable: not thousands of empty ticks
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    CURL_async_destroy(curl_async);
+
+    CURL_trace_enable(false);
+    const bool ok = CURL_trace_dump("curl_trace.json");
+    assert(ok);
+    std::println("trace written to curl_trace.json, open with ui.perfetto.dev");
+}
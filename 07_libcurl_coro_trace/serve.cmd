@@ -0,0 +1 @@
+python -m http.server 5001
@@ -0,0 +1,728 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <chrono>
+#include <charconv>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <ctime>
+#include <csignal>
+
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// Static file server for samples and benchmarks, a drop-in for
+// `python -m http.server 5001`: GET only, HTTP/1.1 keep-alive and pipelining,
+// Last-Modified/If-Modified-Since, files sent with sendfile().
+// One epoll loop per thread, each with its own SO_REUSEPORT listening
+// socket, so threads share nothing and the kernel balances connections.
+// Extra endpoint: GET /bytes/<N> returns N generated bytes.
+struct Srv_Options
+{
+    std::uint16_t port = 5001;
+    std::string root = ".";
+    unsigned threads = 1;
+    // artificial latency before every response is sent
+    std::chrono::milliseconds delay{0};
+    // upper bound for /bytes/<N>
+    std::size_t max_generated_bytes = 64 * 1024 * 1024;
+};
+
+static const char kSrv_Usage[] =
+    "usage: 08_http_test_server [--port 5001] [--root .] [--threads 1]\n"
+    "                           [--delay-ms 0] [--max-bytes 67108864]";
+
+// Last-Modified/If-Modified-Since format
+static std::string Srv_HttpDate(std::time_t time)
+{
+    std::tm tm{};
+    (void)gmtime_r(&time, &tm);
+    char buffer[64]{};
+    const std::size_t size = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return std::string(buffer, size);
+}
+
+static bool Srv_IEquals(std::string_view lhs, std::string_view rhs)
+{
+    return std::ranges::equal(lhs, rhs, [](char l, char r)
+    {
+        return (std::tolower(static_cast<unsigned char>(l)) == std::tolower(static_cast<unsigned char>(r)));
+    });
+}
+
+static std::string_view Srv_Trim(std::string_view str)
+{
+    while (!str.empty() && ((str.front() == ' ') || (str.front() == '\t')))
+    {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && ((str.back() == ' ') || (str.back() == '\t') || (str.back() == '\r')))
+    {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+struct Srv_Request
+{
+    std::string_view method;
+    std::string_view path;
+    std::string_view if_modified_since;
+    bool keep_alive = true;
+};
+
+// parses request line and headers we care about from `head`
+// (everything before \r\n\r\n); false on malformed request
+static bool Srv_ParseRequest(std::string_view head, Srv_Request& request)
+{
+    const std::size_t line_end = head.find("\r\n");
+    const std::string_view line = head.substr(0, line_end);
+    const std::size_t sp1 = line.find(' ');
+    const std::size_t sp2 = line.rfind(' ');
+    if ((sp1 == std::string_view::npos) || (sp2 == sp1))
+    {
+        return false;
+    }
+    request.method = line.substr(0, sp1);
+    request.path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    const std::string_view version = line.substr(sp2 + 1);
+    request.keep_alive = (version == "HTTP/1.1");
+
+    std::string_view headers = (line_end == std::string_view::npos)
+        ? std::string_view{}
+        : head.substr(line_end + 2);
+    while (!headers.empty())
+    {
+        const std::size_t end = headers.find("\r\n");
+        const std::string_view header = headers.substr(0, end);
+        headers = (end == std::string_view::npos) ? std::string_view{} : headers.substr(end + 2);
+        const std::size_t colon = header.find(':');
+        if (colon == std::string_view::npos)
+        {
+            continue;
+        }
+        const std::string_view name = Srv_Trim(header.substr(0, colon));
+        const std::string_view value = Srv_Trim(header.substr(colon + 1));
+        if (Srv_IEquals(name, "Connection"))
+        {
+            request.keep_alive = Srv_IEquals(value, "keep-alive")
+                || (request.keep_alive && !Srv_IEquals(value, "close"));
+        }
+        else if (Srv_IEquals(name, "If-Modified-Since"))
+        {
+            request.if_modified_since = value;
+        }
+    }
+    return true;
+}
+
+struct Srv_Connection
+{
+    int fd = -1;
+    // distinguishes connections that reuse the same fd
+    std::uint64_t serial = 0;
+    std::string input;
+    // response in progress: head, then either file or generated body
+    std::string head;
+    std::size_t head_sent = 0;
+    int file_fd = -1;
+    off_t file_offset = 0;
+    std::size_t body_left = 0;
+    std::size_t generated_sent = 0;
+    bool keep_alive = true;
+    bool responding = false;
+    bool waiting_delay = false;
+    bool wants_write = false;
+    // peer half-closed: answer complete requests received so far, then close
+    bool read_closed = false;
+};
+
+struct Srv_Loop
+{
+    using Clock = std::chrono::steady_clock;
+
+    Srv_Loop(const Srv_Options& options, const std::string& generated);
+    ~Srv_Loop();
+    // no copy, no move
+    Srv_Loop(const Srv_Loop&) = delete;
+
+    void run();
+    void accept_all();
+    void on_readable(Srv_Connection& connection);
+    void process_input(Srv_Connection& connection);
+    void prepare_response(Srv_Connection& connection, const Srv_Request& request);
+    // false if connection was closed
+    bool send_pending(Srv_Connection& connection);
+    bool finish_response(Srv_Connection& connection);
+    void continue_response(Srv_Connection& connection);
+    void set_wants_write(Srv_Connection& connection, bool wants_write);
+    void update_events(Srv_Connection& connection);
+    void close_connection(Srv_Connection& connection);
+    int next_timeout_ms() const;
+    void fire_delays();
+
+    struct Delayed
+    {
+        Clock::time_point deadline;
+        int fd = -1;
+        std::uint64_t serial = 0;
+
+        bool operator>(const Delayed& rhs) const
+        {
+            return (deadline > rhs.deadline);
+        }
+    };
+
+    const Srv_Options& _options;
+    // shared, read-only body for /bytes/<N>
+    const std::string& _generated;
+    int _listen_fd = -1;
+    int _epoll_fd = -1;
+    std::uint64_t _next_serial = 1;
+    // indexed by fd: fds are small, dense integers
+    std::vector<std::unique_ptr<Srv_Connection>> _connections;
+    std::priority_queue<Delayed, std::vector<Delayed>, std::greater<Delayed>> _delayed;
+};
+
+Srv_Loop::Srv_Loop(const Srv_Options& options, const std::string& generated)
+    : _options{options}
+    , _generated{generated}
+{
+    _listen_fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    assert(_listen_fd >= 0);
+    int on = 1;
+    int status = setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    assert(status == 0);
+    status = setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    assert(status == 0);
+    // accept both IPv4 and IPv6: "localhost" may resolve to either
+    int off = 0;
+    status = setsockopt(_listen_fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    assert(status == 0);
+
+    sockaddr_in6 address{};
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(_options.port);
+    status = bind(_listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    assert((status == 0) && "port is already in use?");
+    status = listen(_listen_fd, SOMAXCONN);
+    assert(status == 0);
+
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    assert(_epoll_fd >= 0);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = _listen_fd;
+    status = epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _listen_fd, &event);
+    assert(status == 0);
+}
+
+Srv_Loop::~Srv_Loop()
+{
+    for (std::unique_ptr<Srv_Connection>& connection : _connections)
+    {
+        if (connection)
+        {
+            close_connection(*connection);
+        }
+    }
+    (void)close(_epoll_fd);
+    (void)close(_listen_fd);
+}
+
+void Srv_Loop::run()
+{
+    std::vector<epoll_event> events(256);
+    while (true)
+    {
+        const int count = epoll_wait(_epoll_fd, events.data(), static_cast<int>(events.size()), next_timeout_ms());
+        if ((count < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        assert(count >= 0);
+        for (int i = 0; i < count; ++i)
+        {
+            const epoll_event& event = events[static_cast<std::size_t>(i)];
+            if (event.data.fd == _listen_fd)
+            {
+                accept_all();
+                continue;
+            }
+            Srv_Connection* connection = _connections[static_cast<std::size_t>(event.data.fd)].get();
+            if (!connection)
+            {   // closed by previous event in this batch
+                continue;
+            }
+            if (event.events & EPOLLERR)
+            {
+                close_connection(*connection);
+                continue;
+            }
+            if (event.events & EPOLLHUP)
+            {   // can't wait for EPOLLOUT or delays anymore: answer what's
+                // already buffered, as far as the socket takes it, and close
+                on_readable(*connection);
+                if (Srv_Connection* alive = _connections[static_cast<std::size_t>(event.data.fd)].get())
+                {
+                    close_connection(*alive);
+                }
+                continue;
+            }
+            if (event.events & EPOLLOUT)
+            {
+                continue_response(*connection);
+            }
+            connection = _connections[static_cast<std::size_t>(event.data.fd)].get();
+            if (connection && (event.events & EPOLLIN))
+            {
+                on_readable(*connection);
+            }
+        }
+        fire_delays();
+    }
+}
+
+void Srv_Loop::accept_all()
+{
+    while (true)
+    {
+        const int fd = accept4(_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {   // EAGAIN: accepted everything; anything else: try on next event
+            return;
+        }
+        int on = 1;
+        (void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        const std::size_t index = static_cast<std::size_t>(fd);
+        if (index >= _connections.size())
+        {
+            _connections.resize(std::max(index + 1, _connections.size() * 2));
+        }
+        assert(!_connections[index]);
+        _connections[index] = std::make_unique<Srv_Connection>();
+        _connections[index]->fd = fd;
+        _connections[index]->serial = _next_serial++;
+
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        const int status = epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        assert(status == 0);
+    }
+}
+
+void Srv_Loop::on_readable(Srv_Connection& connection)
+{
+    char buffer[16 * 1024];
+    while (true)
+    {
+        const ssize_t size = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (size > 0)
+        {
+            connection.input.append(buffer, static_cast<std::size_t>(size));
+            continue;
+        }
+        if ((size < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            break;
+        }
+        if ((size < 0) && (errno == EINTR))
+        {
+            continue;
+        }
+        if (size < 0)
+        {
+            close_connection(connection);
+            return;
+        }
+        // 0: peer closed its side, may still read responses
+        connection.read_closed = true;
+        update_events(connection);
+        break;
+    }
+    process_input(connection);
+}
+
+void Srv_Loop::process_input(Srv_Connection& connection)
+{
+    // pipelining: handle requests one by one, in order
+    while (!connection.responding)
+    {
+        const std::size_t head_end = connection.input.find("\r\n\r\n");
+        if (head_end == std::string::npos)
+        {
+            if (connection.read_closed || (connection.input.size() > 64 * 1024))
+            {   // all answered, or no sane GET has headers this big
+                close_connection(connection);
+            }
+            return;
+        }
+        Srv_Request request;
+        const std::string head = connection.input.substr(0, head_end);
+        connection.input.erase(0, head_end + 4);
+        if (!Srv_ParseRequest(head, request))
+        {
+            close_connection(connection);
+            return;
+        }
+        prepare_response(connection, request);
+        if (_options.delay.count() > 0)
+        {
+            connection.waiting_delay = true;
+            _delayed.push(Delayed{Clock::now() + _options.delay, connection.fd, connection.serial});
+            return;
+        }
+        if (!send_pending(connection))
+        {
+            return;
+        }
+    }
+}
+
+void Srv_Loop::continue_response(Srv_Connection& connection)
+{
+    if (send_pending(connection) && !connection.responding)
+    {   // done, next pipelined request, if any
+        process_input(connection);
+    }
+}
+
+void Srv_Loop::prepare_response(Srv_Connection& connection, const Srv_Request& request)
+{
+    connection.responding = true;
+    connection.keep_alive = request.keep_alive;
+    connection.head_sent = 0;
+    connection.generated_sent = 0;
+    connection.body_left = 0;
+
+    const char* status_line = "HTTP/1.1 200 OK";
+    std::string extra_headers;
+    std::string_view path = request.path.substr(0, request.path.find('?'));
+    bool has_body = (request.method != "HEAD");
+    // RFC 9110: 304 carries no Content-Length (unless equal to the 200 one)
+    bool has_content_length = true;
+    if ((request.method != "GET") && (request.method != "HEAD"))
+    {
+        status_line = "HTTP/1.1 405 Method Not Allowed";
+        has_body = false;
+    }
+    else if (path.starts_with("/bytes/"))
+    {
+        const std::string_view number = path.substr(7);
+        std::size_t size = 0;
+        const auto [_, ec] = std::from_chars(number.data(), number.data() + number.size(), size);
+        if ((ec != std::errc{}) || (size > _generated.size()))
+        {
+            status_line = "HTTP/1.1 400 Bad Request";
+            has_body = false;
+        }
+        else
+        {
+            connection.body_left = size;
+        }
+    }
+    else if (path.find("..") != std::string_view::npos)
+    {
+        status_line = "HTTP/1.1 403 Forbidden";
+        has_body = false;
+    }
+    else
+    {
+        const std::string file_path = _options.root + std::string(path);
+        const int file_fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info{};
+        if ((file_fd < 0) || (fstat(file_fd, &info) != 0) || !S_ISREG(info.st_mode))
+        {
+            if (file_fd >= 0)
+            {
+                (void)close(file_fd);
+            }
+            status_line = "HTTP/1.1 404 Not Found";
+            has_body = false;
+        }
+        else
+        {
+            const std::string last_modified = Srv_HttpDate(info.st_mtime);
+            extra_headers += "Last-Modified: " + last_modified + "\r\n";
+            if (request.if_modified_since == last_modified)
+            {
+                status_line = "HTTP/1.1 304 Not Modified";
+                has_body = false;
+                has_content_length = false;
+                (void)close(file_fd);
+            }
+            else
+            {
+                connection.file_fd = file_fd;
+                connection.file_offset = 0;
+                connection.body_left = static_cast<std::size_t>(info.st_size);
+            }
+        }
+    }
+    if (!has_body && (connection.file_fd >= 0))
+    {   // HEAD
+        (void)close(connection.file_fd);
+        connection.file_fd = -1;
+    }
+
+    connection.head = status_line;
+    connection.head += "\r\nServer: 08_http_test_server\r\nContent-Type: text/plain\r\n";
+    connection.head += extra_headers;
+    if (has_content_length)
+    {
+        connection.head += "Content-Length: " + std::to_string(connection.body_left) + "\r\n";
+    }
+    connection.head += connection.keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    if (!has_body)
+    {
+        connection.body_left = 0;
+    }
+}
+
+bool Srv_Loop::send_pending(Srv_Connection& connection)
+{
+    if (!connection.responding || connection.waiting_delay)
+    {
+        return true;
+    }
+    while (connection.head_sent < connection.head.size())
+    {
+        const ssize_t sent = send(connection.fd
+            , connection.head.data() + connection.head_sent
+            , connection.head.size() - connection.head_sent
+            , MSG_NOSIGNAL | ((connection.body_left > 0) ? MSG_MORE : 0));
+        if (sent < 0)
+        {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                set_wants_write(connection, true);
+                return true;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            close_connection(connection);
+            return false;
+        }
+        connection.head_sent += static_cast<std::size_t>(sent);
+    }
+    while (connection.body_left > 0)
+    {
+        ssize_t sent = -1;
+        if (connection.file_fd >= 0)
+        {
+            sent = sendfile(connection.fd, connection.file_fd, &connection.file_offset, connection.body_left);
+        }
+        else
+        {
+            sent = send(connection.fd
+                , _generated.data() + connection.generated_sent
+                , connection.body_left
+                , MSG_NOSIGNAL);
+            if (sent > 0)
+            {
+                connection.generated_sent += static_cast<std::size_t>(sent);
+            }
+        }
+        if (sent < 0)
+        {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            {
+                set_wants_write(connection, true);
+                return true;
+            }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            close_connection(connection);
+            return false;
+        }
+        if (sent == 0)
+        {   // file was truncated while sending
+            close_connection(connection);
+            return false;
+        }
+        connection.body_left -= static_cast<std::size_t>(sent);
+    }
+    return finish_response(connection);
+}
+
+bool Srv_Loop::finish_response(Srv_Connection& connection)
+{
+    if (connection.file_fd >= 0)
+    {
+        (void)close(connection.file_fd);
+        connection.file_fd = -1;
+    }
+    connection.responding = false;
+    set_wants_write(connection, false);
+    if (!connection.keep_alive)
+    {
+        close_connection(connection);
+        return false;
+    }
+    return true;
+}
+
+void Srv_Loop::set_wants_write(Srv_Connection& connection, bool wants_write)
+{
+    if (connection.wants_write == wants_write)
+    {
+        return;
+    }
+    connection.wants_write = wants_write;
+    update_events(connection);
+}
+
+void Srv_Loop::update_events(Srv_Connection& connection)
+{
+    epoll_event event{};
+    if (!connection.read_closed)
+    {   // level-triggered EOF would fire forever
+        event.events = EPOLLIN | EPOLLRDHUP;
+    }
+    if (connection.wants_write)
+    {
+        event.events |= EPOLLOUT;
+    }
+    event.data.fd = connection.fd;
+    const int status = epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+    assert(status == 0);
+}
+
+void Srv_Loop::close_connection(Srv_Connection& connection)
+{
+    if (connection.file_fd >= 0)
+    {
+        (void)close(connection.file_fd);
+    }
+    const int fd = connection.fd;
+    // closing fd also removes it from epoll
+    (void)close(fd);
+    _connections[static_cast<std::size_t>(fd)].reset();
+}
+
+int Srv_Loop::next_timeout_ms() const
+{
+    if (_delayed.empty())
+    {
+        return -1;
+    }
+    const auto left = std::chrono::ceil<std::chrono::milliseconds>(_delayed.top().deadline - Clock::now());
+    return static_cast<int>(std::max<std::chrono::milliseconds::rep>(left.count(), 0));
+}
+
+void Srv_Loop::fire_delays()
+{
+    const Clock::time_point now = Clock::now();
+    while (!_delayed.empty() && (_delayed.top().deadline <= now))
+    {
+        const Delayed delayed = _delayed.top();
+        _delayed.pop();
+        Srv_Connection* connection = _connections[static_cast<std::size_t>(delayed.fd)].get();
+        if (!connection || (connection->serial != delayed.serial))
+        {   // closed while waiting
+            continue;
+        }
+        connection->waiting_delay = false;
+        continue_response(*connection);
+    }
+}
+
+static bool Srv_ParseOptions(int argc, char* argv[], Srv_Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if ((i + 1) >= argc)
+        {
+            return false;
+        }
+        const std::string_view value = argv[++i];
+        const auto to_number = [&](auto& number)
+        {
+            const auto [_, ec] = std::from_chars(value.data(), value.data() + value.size(), number);
+            return (ec == std::errc{});
+        };
+        bool ok = true;
+        if (arg == "--port")
+        {
+            ok = to_number(options.port);
+        }
+        else if (arg == "--root")
+        {
+            options.root = value;
+        }
+        else if (arg == "--threads")
+        {
+            ok = to_number(options.threads) && (options.threads > 0);
+        }
+        else if (arg == "--delay-ms")
+        {
+            long long ms = 0;
+            ok = to_number(ms) && (ms >= 0);
+            options.delay = std::chrono::milliseconds{ms};
+        }
+        else if (arg == "--max-bytes")
+        {
+            ok = to_number(options.max_generated_bytes);
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    Srv_Options options;
+    if (!Srv_ParseOptions(argc, argv, options))
+    {
+        std::println(stderr, "{}", kSrv_Usage);
+        return 1;
+    }
+    // peer may close while sendfile() is in progress
+    (void)std::signal(SIGPIPE, SIG_IGN);
+
+    const std::string generated(options.max_generated_bytes, 'x');
+    std::vector<std::jthread> threads;
+    for (unsigned i = 0; i < options.threads; ++i)
+    {
+        threads.emplace_back([&options, &generated]()
+        {
+            Srv_Loop loop{options, generated};
+            loop.run();
+        });
+    }
+    std::println("serving '{}' on port {}, {} thread(s), delay {} ms"
+        , options.root, options.port, options.threads, options.delay.count());
+}
@@ -0,0 +1,732 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <charconv>
+#include <algorithm>
+#include <coroutine>
+#include <utility>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+
+#if !defined(_WIN32)
+#  include <sys/resource.h>
+#endif
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// Same fetch, four API styles, N requests in flight:
+// blocking (thread per in-flight request), callbacks, coroutines, std::future.
+// Run against 08_http_test_server, not python (it is the bottleneck):
+//   08_http_test_server --threads 4
+//   09_benchmark_api_styles [url] [requests per level] [levels...]
+
+// allocations: both C++ operator new and libcurl's own malloc/calloc/realloc/strdup
+static std::atomic<std::uint64_t> g_Bench_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    g_Bench_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+static void* Bench_CurlMalloc(size_t size)
+{
+    g_Bench_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size);
+}
+
+static void* Bench_CurlCalloc(size_t count, size_t size)
+{
+    g_Bench_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::calloc(count, size);
+}
+
+static void* Bench_CurlRealloc(void* ptr, size_t size)
+{
+    g_Bench_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::realloc(ptr, size);
+}
+
+static char* Bench_CurlStrdup(const char* str)
+{
+    const std::size_t size = std::strlen(str) + 1;
+    char* copy = static_cast<char*>(Bench_CurlMalloc(size));
+    if (copy)
+    {
+        std::memcpy(copy, str, size);
+    }
+    return copy;
+}
+
+static void Bench_CurlFree(void* ptr)
+{
+    std::free(ptr);
+}
+
+// blocking API
+std::string CURL_get(const std::string& url);
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+// sleeps until there is socket activity (or timeout), instead of spinning;
+// otherwise CPU time of every async style is 100% of a core
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout);
+
+// main async callback API
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+// coro await
+struct Co_CurlAsync;
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+std::string CURL_get(const std::string& url)
+{
+    CURL* curl = curl_easy_init();
+    assert(curl);
+
+    CURLcode status = curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    std::string response;
+    status = curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+    assert(status == CURLE_OK);
+
+    status = curl_easy_perform(curl);
+    assert(status == CURLE_OK);
+
+    long response_code = -1;
+    status = curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+    assert(status == CURLE_OK);
+    assert(response_code == 200L);
+
+    curl_easy_cleanup(curl);
+    return response;
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout)
+{
+    const CURLMcode status = curl_multi_poll(CURL_scheduler(curl_async)._multi_curl
+        , nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    assert(status == CURLM_OK);
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to separate std::string
+    std::string* state = new std::string{};
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    CURL_scheduler(curl_async).add_request(curl_easy
+        , [state, user_data, callback](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(*state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+}
+
+struct Co_Task
+{
+    struct promise_type;
+    using co_handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type
+    {
+        Co_Task get_return_object()
+        {
+            return Co_Task{co_handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+            // yeah, we return void. Nothing to do
+        }
+
+        void unhandled_exception()
+        {
+            // crash, no exceptions handling
+            assert(false);
+        }
+    };
+
+    Co_Task(co_handle coro)
+        : _coro{coro} {}
+    Co_Task(Co_Task&& rhs) noexcept
+        : _coro{std::exchange(rhs._coro, {})} { }
+    Co_Task(const Co_Task&) = delete;
+    ~Co_Task() noexcept
+    {
+        if (_coro)
+        {
+            _coro.destroy();
+        }
+    }
+
+    void resume()
+    {
+        assert(_coro);
+        assert(!_coro.done());
+        _coro.resume();
+    }
+
+    bool is_in_progress() const
+    {
+        assert(_coro);
+        return !_coro.done();
+    }
+
+    co_handle _coro;
+};
+
+struct Co_CurlAsync
+{
+    CURL_Async _curl_async{};
+    std::string _url;
+    std::coroutine_handle<> _coro;
+    std::string _response;
+
+    bool await_ready()
+    { // 1. CURL_async_get() is not yet started, force coroutine suspend:
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    { // 2. remember coroutine handle, start request, resume on finish:
+        _coro = coro;
+
+        CURL_async_get(_curl_async, _url, this
+            , [](void* user_data, std::string response)
+        {
+            Co_CurlAsync& self = *static_cast<Co_CurlAsync*>(user_data);
+            self._response = std::move(response);
+            self._coro.resume();
+        });
+    }
+
+    std::string await_resume()
+    { // 3. after resume, return response:
+        return std::move(_response);
+    }
+};
+
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url)
+{
+    Co_CurlAsync awaiter;
+    awaiter._curl_async = curl_async;
+    awaiter._url = url;
+    return awaiter;
+}
+
+// benchmark harness
+using Bench_Clock = std::chrono::steady_clock;
+
+struct Bench_Run
+{
+    std::string url;
+    std::size_t concurrency = 0;
+    std::size_t requests = 0;
+    // per request, microseconds; preallocated so the run itself
+    // does not pay for (and count) vector growth
+    std::vector<double> latencies_us;
+    std::size_t started = 0;
+    std::size_t finished = 0;
+
+    void record(std::size_t index, Bench_Clock::time_point started_at)
+    {
+        latencies_us[index] = std::chrono::duration<double, std::micro>(Bench_Clock::now() - started_at).count();
+        ++finished;
+    }
+};
+
+struct Bench_Result
+{
+    const char* style = nullptr;
+    std::size_t concurrency = 0;
+    std::size_t requests = 0;
+    double wall_seconds = 0;
+    double cpu_seconds = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double p999_us = 0;
+    double allocations_per_request = 0;
+    bool skipped = false;
+};
+
+static double Bench_Percentile(std::vector<double>& sorted, double p)
+{
+    const std::size_t index = std::min(sorted.size() - 1
+        , static_cast<std::size_t>(p * static_cast<double>(sorted.size())));
+    return sorted[index];
+}
+
+// runs `body` and fills everything except style
+template<typename F>
+static Bench_Result Bench_Measure(Bench_Run& run, F&& body)
+{
+    const std::uint64_t allocations_before = g_Bench_allocations.load();
+    const std::clock_t cpu_before = std::clock();
+    const Bench_Clock::time_point wall_before = Bench_Clock::now();
+    body();
+    const Bench_Clock::time_point wall_after = Bench_Clock::now();
+    const std::clock_t cpu_after = std::clock();
+    const std::uint64_t allocations_after = g_Bench_allocations.load();
+
+    Bench_Result result;
+    result.concurrency = run.concurrency;
+    result.requests = run.requests;
+    result.wall_seconds = std::chrono::duration<double>(wall_after - wall_before).count();
+    result.cpu_seconds = static_cast<double>(cpu_after - cpu_before) / CLOCKS_PER_SEC;
+    result.allocations_per_request = static_cast<double>(allocations_after - allocations_before)
+        / static_cast<double>(run.requests);
+    std::sort(run.latencies_us.begin(), run.latencies_us.end());
+    result.p50_us = Bench_Percentile(run.latencies_us, 0.50);
+    result.p99_us = Bench_Percentile(run.latencies_us, 0.99);
+    result.p999_us = Bench_Percentile(run.latencies_us, 0.999);
+    return result;
+}
+
+// App_Blocking: one thread per in-flight request
+static Bench_Result Bench_Blocking(Bench_Run& run, std::size_t max_threads)
+{
+    if (run.concurrency > max_threads)
+    {
+        Bench_Result skipped;
+        skipped.concurrency = run.concurrency;
+        skipped.skipped = true;
+        return skipped;
+    }
+    std::atomic<std::size_t> next{0};
+    return Bench_Measure(run, [&]()
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(run.concurrency);
+        for (std::size_t i = 0; i < run.concurrency; ++i)
+        {
+            threads.emplace_back([&]()
+            {
+                for (std::size_t index = next++; index < run.requests; index = next++)
+                {
+                    const Bench_Clock::time_point started_at = Bench_Clock::now();
+                    const std::string response = CURL_get(run.url);
+                    assert(!response.empty());
+                    run.latencies_us[index] = std::chrono::duration<double, std::micro>(
+                        Bench_Clock::now() - started_at).count();
+                }
+            });
+        }
+    });
+}
+
+// App_Callbacks: fixed array of slots, each restarts itself on completion
+static Bench_Result Bench_Callbacks(Bench_Run& run)
+{
+    struct Slot
+    {
+        Bench_Run* run = nullptr;
+        CURL_Async curl_async = nullptr;
+        std::size_t index = 0;
+        Bench_Clock::time_point started_at;
+
+        void start()
+        {
+            index = run->started++;
+            started_at = Bench_Clock::now();
+            CURL_async_get(curl_async, run->url, this
+                , [](void* user_data, std::string response)
+            {
+                assert(!response.empty());
+                Slot& self = *static_cast<Slot*>(user_data);
+                self.run->record(self.index, self.started_at);
+                if (self.run->started < self.run->requests)
+                {
+                    self.start();
+                }
+            });
+        }
+    };
+
+    CURL_Async curl_async = CURL_async_create();
+    std::vector<Slot> slots(run.concurrency);
+    Bench_Result result = Bench_Measure(run, [&]()
+    {
+        for (Slot& slot : slots)
+        {
+            slot.run = &run;
+            slot.curl_async = curl_async;
+            slot.start();
+        }
+        while (run.finished < run.requests)
+        {
+            CURL_async_wait(curl_async, std::chrono::milliseconds{100});
+            CURL_async_tick(curl_async);
+        }
+    });
+    CURL_async_destroy(curl_async);
+    return result;
+}
+
+// coroutines: one long-lived coroutine per in-flight request
+static Co_Task Bench_CoroWorker(CURL_Async curl_async, Bench_Run& run)
+{
+    while (run.started < run.requests)
+    {
+        const std::size_t index = run.started++;
+        const Bench_Clock::time_point started_at = Bench_Clock::now();
+        const std::string response = co_await CURL_await_get(curl_async, run.url);
+        assert(!response.empty());
+        run.record(index, started_at);
+    }
+}
+
+static Bench_Result Bench_Coroutines(Bench_Run& run)
+{
+    CURL_Async curl_async = CURL_async_create();
+    std::vector<Co_Task> tasks;
+    Bench_Result result = Bench_Measure(run, [&]()
+    {
+        tasks.reserve(run.concurrency);
+        for (std::size_t i = 0; i < run.concurrency; ++i)
+        {
+            tasks.push_back(Bench_CoroWorker(curl_async, run));
+            tasks.back().resume();
+        }
+        while (run.finished < run.requests)
+        {
+            CURL_async_wait(curl_async, std::chrono::milliseconds{100});
+            CURL_async_tick(curl_async);
+        }
+    });
+    tasks.clear();
+    CURL_async_destroy(curl_async);
+    return result;
+}
+
+// async polling std::future/promise: poll every in-flight future each tick
+static Bench_Result Bench_Futures(Bench_Run& run)
+{
+    struct InFlight
+    {
+        std::future<std::string> future;
+        std::size_t index = 0;
+        Bench_Clock::time_point started_at;
+    };
+
+    CURL_Async curl_async = CURL_async_create();
+    const auto start = [&](InFlight& in_flight)
+    {
+        std::promise<std::string>* promise = new std::promise<std::string>{};
+        in_flight.future = promise->get_future();
+        in_flight.index = run.started++;
+        in_flight.started_at = Bench_Clock::now();
+        CURL_async_get(curl_async, run.url, promise
+            , [](void* user_data, std::string response)
+        {
+            std::promise<std::string>* promise_ = static_cast<std::promise<std::string>*>(user_data);
+            promise_->set_value(std::move(response));
+            delete promise_;
+        });
+    };
+
+    std::vector<InFlight> in_flight(run.concurrency);
+    Bench_Result result = Bench_Measure(run, [&]()
+    {
+        for (InFlight& f : in_flight)
+        {
+            start(f);
+        }
+        while (run.finished < run.requests)
+        {
+            CURL_async_wait(curl_async, std::chrono::milliseconds{100});
+            CURL_async_tick(curl_async);
+            for (InFlight& f : in_flight)
+            {
+                if (!f.future.valid()
+                    || (f.future.wait_for(std::chrono::seconds{0}) != std::future_status::ready))
+                {
+                    continue;
+                }
+                const std::string response = f.future.get();
+                assert(!response.empty());
+                run.record(f.index, f.started_at);
+                if (run.started < run.requests)
+                {
+                    start(f);
+                }
+            }
+        }
+    });
+    CURL_async_destroy(curl_async);
+    return result;
+}
+
+static void Bench_Print(const Bench_Result& r)
+{
+    if (r.skipped)
+    {
+        std::println("{:>12} {:>8}  skipped (too many threads)", r.style, r.concurrency);
+        return;
+    }
+    std::println("{:>12} {:>8} {:>10.0f} {:>10.0f} {:>10.0f} {:>10.0f} {:>9.1f} {:>8.1f}"
+        , r.style
+        , r.concurrency
+        , static_cast<double>(r.requests) / r.wall_seconds
+        , r.p50_us
+        , r.p99_us
+        , r.p999_us
+        , 1e6 * r.cpu_seconds / static_cast<double>(r.requests)
+        , r.allocations_per_request);
+}
+
+static void Bench_RaiseFileLimit()
+{
+#if !defined(_WIN32)
+    // one socket per in-flight request
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        (void)setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+    std::string url = "localhost:5001/file1.txt";
+    std::size_t requests_per_level = 2000;
+    std::vector<std::size_t> levels = {1, 10, 100, 1'000, 10'000};
+    if (argc > 1)
+    {
+        url = argv[1];
+    }
+    if (argc > 2)
+    {
+        const std::string_view arg = argv[2];
+        (void)std::from_chars(arg.data(), arg.data() + arg.size(), requests_per_level);
+    }
+    if (argc > 3)
+    {
+        levels.clear();
+        for (int i = 3; i < argc; ++i)
+        {
+            const std::string_view arg = argv[i];
+            std::size_t level = 0;
+            (void)std::from_chars(arg.data(), arg.data() + arg.size(), level);
+            assert(level > 0);
+            levels.push_back(level);
+        }
+    }
+    Bench_RaiseFileLimit();
+    const CURLcode status = curl_global_init_mem(CURL_GLOBAL_ALL
+        , Bench_CurlMalloc, Bench_CurlFree, Bench_CurlRealloc, Bench_CurlStrdup, Bench_CurlCalloc);
+    assert(status == CURLE_OK);
+
+    std::println("{}, at least {} requests per level", url, requests_per_level);
+    std::println("{:>12} {:>8} {:>10} {:>10} {:>10} {:>10} {:>9} {:>8}"
+        , "style", "inflight", "req/s", "p50 us", "p99 us", "p99.9 us", "cpu us/r", "alloc/r");
+    const std::size_t max_threads = 1'000;
+    for (const std::size_t concurrency : levels)
+    {
+        const auto make_run = [&]()
+        {
+            Bench_Run run;
+            run.url = url;
+            run.concurrency = concurrency;
+            // every worker does at least a few requests
+            run.requests = std::max(requests_per_level, concurrency * 2);
+            run.latencies_us.resize(run.requests);
+            return run;
+        };
+        const auto report = [](const char* style, Bench_Result result)
+        {
+            result.style = style;
+            Bench_Print(result);
+        };
+        {
+            Bench_Run run = make_run();
+            report("blocking", Bench_Blocking(run, max_threads));
+        }
+        {
+            Bench_Run run = make_run();
+            report("callbacks", Bench_Callbacks(run));
+        }
+        {
+            Bench_Run run = make_run();
+            report("coroutines", Bench_Coroutines(run));
+        }
+        {
+            Bench_Run run = make_run();
+            report("futures", Bench_Futures(run));
+        }
+    }
+    curl_global_cleanup();
+}
@@ -0,0 +1,645 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <coroutine>
+#include <utility>
+#include <cstdint>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// what the scheduler needs from the network layer;
+// libcurl multi in production, in-memory fake for microbenchmarks
+using CURL_TransferId = void*;
+
+struct CURL_Transport
+{
+    virtual ~CURL_Transport() = default;
+    // begins GET, response body is appended to `response`
+    virtual CURL_TransferId start(const std::string& url, std::string& response) = 0;
+    // makes progress; appends finished transfers to `done`
+    virtual void perform(std::vector<CURL_TransferId>& done) = 0;
+    // returns HTTP response code, releases the transfer
+    virtual long finish(CURL_TransferId transfer) = 0;
+};
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+// libcurl multi transport
+CURL_Async CURL_async_create();
+// caller-owned transport, must outlive the scheduler
+CURL_Async CURL_async_create(CURL_Transport& transport);
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+
+// main async callback API
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+// coro await
+struct Co_CurlAsync;
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+struct CURL_MultiTransport : CURL_Transport
+{
+    CURL_MultiTransport();
+    ~CURL_MultiTransport() override;
+    // no copy, no move
+    CURL_MultiTransport(const CURL_MultiTransport&) = delete;
+
+    CURL_TransferId start(const std::string& url, std::string& response) override;
+    void perform(std::vector<CURL_TransferId>& done) override;
+    long finish(CURL_TransferId transfer) override;
+
+    CURLM* _multi_curl = nullptr;
+};
+
+CURL_MultiTransport::CURL_MultiTransport()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_MultiTransport::~CURL_MultiTransport()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+CURL_TransferId CURL_MultiTransport::start(const std::string& url, std::string& response)
+{
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, &response);
+    assert(status == CURLE_OK);
+    const CURLMcode mstatus = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(mstatus == CURLM_OK);
+    return curl_easy;
+}
+
+void CURL_MultiTransport::perform(std::vector<CURL_TransferId>& done)
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        done.push_back(curl_easy);
+    }
+}
+
+long CURL_MultiTransport::finish(CURL_TransferId transfer)
+{
+    CURL* curl_easy = static_cast<CURL*>(transfer);
+    long response_code = -1;
+    const CURLcode status = curl_easy_getinfo(curl_easy, CURLINFO_RESPONSE_CODE, &response_code);
+    assert(status == CURLE_OK);
+    curl_easy_cleanup(curl_easy);
+    return response_code;
+}
+
+// in-process fake: every transfer completes `delay_ticks` perform() calls
+// after start() with a canned body; transfers are pooled and deadlines are
+// kept in a timing wheel, so the fake itself adds next to nothing
+struct CURL_FakeTransport : CURL_Transport
+{
+    struct Transfer
+    {
+        std::string* response = nullptr;
+    };
+
+    explicit CURL_FakeTransport(std::string body, std::size_t delay_ticks = 0);
+
+    CURL_TransferId start(const std::string& url, std::string& response) override;
+    void perform(std::vector<CURL_TransferId>& done) override;
+    long finish(CURL_TransferId transfer) override;
+
+    std::string _body;
+    std::uint64_t _tick = 0;
+    // slot (tick % size) holds transfers that complete on that tick
+    std::vector<std::vector<Transfer*>> _wheel;
+    std::vector<std::unique_ptr<Transfer>> _storage;
+    std::vector<Transfer*> _free;
+};
+
+CURL_FakeTransport::CURL_FakeTransport(std::string body, std::size_t delay_ticks /*= 0*/)
+    : _body{std::move(body)}
+    , _wheel(delay_ticks + 1)
+{
+}
+
+CURL_TransferId CURL_FakeTransport::start(const std::string& url, std::string& response)
+{
+    (void)url;
+    if (_free.empty())
+    {
+        _storage.push_back(std::make_unique<Transfer>());
+        _free.push_back(_storage.back().get());
+    }
+    Transfer* transfer = _free.back();
+    _free.pop_back();
+    transfer->response = &response;
+    // slot of the current tick comes round again after delay_ticks + 1
+    // perform() calls: never completes within the tick() it was started from
+    _wheel[_tick % _wheel.size()].push_back(transfer);
+    return transfer;
+}
+
+void CURL_FakeTransport::perform(std::vector<CURL_TransferId>& done)
+{
+    ++_tick;
+    std::vector<Transfer*>& due = _wheel[_tick % _wheel.size()];
+    for (Transfer* transfer : due)
+    {
+        transfer->response->append(_body);
+        done.push_back(transfer);
+    }
+    due.clear();
+}
+
+long CURL_FakeTransport::finish(CURL_TransferId transfer)
+{
+    _free.push_back(static_cast<Transfer*>(transfer));
+    return 200L;
+}
+
+struct CURL_AsyncScheduler
+{
+    explicit CURL_AsyncScheduler(CURL_Transport& transport);
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL_TransferId transfer)>;
+
+    void tick();
+    void add_request(CURL_TransferId transfer, Callback on_finish);
+
+    // our state
+    CURL_Transport& _transport;
+    // owned only when created with CURL_async_create()
+    std::unique_ptr<CURL_Transport> _owned_transport;
+    std::unordered_map<CURL_TransferId, Callback> _transfer_to_callback;
+    // reused between ticks
+    std::vector<CURL_TransferId> _done;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler(CURL_Transport& transport)
+    : _transport{transport}
+{
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    _done.clear();
+    _transport.perform(_done);
+    for (CURL_TransferId transfer : _done)
+    {
+        auto it = _transfer_to_callback.find(transfer);
+        assert(it != _transfer_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_transfer_to_callback.erase(it);
+        callback(transfer);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL_TransferId transfer, Callback on_finish)
+{
+    assert(on_finish);
+    assert(transfer);
+    assert(!_transfer_to_callback.contains(transfer));
+    _transfer_to_callback[transfer] = std::move(on_finish);
+}
+
+CURL_Async CURL_async_create()
+{
+    std::unique_ptr<CURL_Transport> transport = std::make_unique<CURL_MultiTransport>();
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler(*transport);
+    assert(scheduler);
+    scheduler->_owned_transport = std::move(transport);
+    return scheduler;
+}
+
+CURL_Async CURL_async_create(CURL_Transport& transport)
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler(transport);
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(curl_async);
+    // 1. response data goes to separate std::string
+    std::string* state = new std::string{};
+    // 2. start transfer
+    CURL_TransferId transfer = scheduler._transport.start(url, *state);
+    // 3. associate with the event loop
+    scheduler.add_request(transfer
+        , [&scheduler, state, user_data, callback](CURL_TransferId transfer_)
+    {
+        const long response_code = scheduler._transport.finish(transfer_);
+        assert(response_code == 200L);
+        std::string data = std::move(*state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+}
+
+struct Co_Task
+{
+    struct promise_type;
+    using co_handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type
+    {
+        Co_Task get_return_object()
+        {
+            return Co_Task{co_handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+            // yeah, we return void. Nothing to do
+        }
+
+        void unhandled_exception()
+        {
+            // crash, no exceptions handling
+            assert(false);
+        }
+    };
+
+    Co_Task(co_handle coro)
+        : _coro{coro} {}
+    Co_Task(Co_Task&& rhs) noexcept
+        : _coro{std::exchange(rhs._coro, {})} { }
+    Co_Task(const Co_Task&) = delete;
+    ~Co_Task() noexcept
+    {
+        if (_coro)
+        {
+            _coro.destroy();
+        }
+    }
+
+    void resume()
+    {
+        assert(_coro);
+        assert(!_coro.done());
+        _coro.resume();
+    }
+
+    bool is_in_progress() const
+    {
+        assert(_coro);
+        return !_coro.done();
+    }
+
+    co_handle _coro;
+};
+
+struct Co_CurlAsync
+{
+    CURL_Async _curl_async{};
+    std::string _url;
+    std::coroutine_handle<> _coro;
+    std::string _response;
+
+    bool await_ready()
+    { // 1. CURL_async_get() is not yet started, force coroutine suspend:
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    { // 2. remember coroutine handle, start request, resume on finish:
+        _coro = coro;
+
+        CURL_async_get(_curl_async, _url, this
+            , [](void* user_data, std::string response)
+        {
+            Co_CurlAsync& self = *static_cast<Co_CurlAsync*>(user_data);
+            self._response = std::move(response);
+            self._coro.resume();
+        });
+    }
+
+    std::string await_resume()
+    { // 3. after resume, return response:
+        return std::move(_response);
+    }
+};
+
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url)
+{
+    Co_CurlAsync awaiter;
+    awaiter._curl_async = curl_async;
+    awaiter._url = url;
+    return awaiter;
+}
+
+// microbenchmark harness
+using Bench_Clock = std::chrono::steady_clock;
+
+// keeps results observable, so the optimizer can't drop the work
+static volatile std::size_t g_Bench_sink = 0;
+
+// best of `repetitions` runs of `body`, each doing `ops` operations
+template<typename F>
+static double Bench_NsPerOp(std::size_t ops, F&& body, int repetitions = 5)
+{
+    double best = 1e300;
+    for (int i = 0; i < repetitions; ++i)
+    {
+        const Bench_Clock::time_point start = Bench_Clock::now();
+        body();
+        const std::chrono::duration<double, std::nano> elapsed = Bench_Clock::now() - start;
+        best = std::min(best, elapsed.count() / static_cast<double>(ops));
+    }
+    return best;
+}
+
+static void Bench_Report(const char* name, double ns_per_op)
+{
+    std::println("{:<48} {:>10.1f} ns/op", name, ns_per_op);
+}
+
+static const char kBench_Url[] = "fake://bench";
+
+// submit `requests` at once, tick until all are done
+static double Bench_CallbacksBurst(std::size_t requests, std::size_t delay_ticks)
+{
+    CURL_FakeTransport transport{"content 1", delay_ticks};
+    CURL_Async curl_async = CURL_async_create(transport);
+    const double ns = Bench_NsPerOp(requests, [&]()
+    {
+        std::size_t done = 0;
+        for (std::size_t i = 0; i < requests; ++i)
+        {
+            CURL_async_get(curl_async, kBench_Url, &done
+                , [](void* user_data, std::string response)
+            {
+                *static_cast<std::size_t*>(user_data) += response.size() ? 1 : 0;
+            });
+        }
+        while (done != requests)
+        {
+            CURL_async_tick(curl_async);
+        }
+        g_Bench_sink = done;
+    });
+    CURL_async_destroy(curl_async);
+    return ns;
+}
+
+// `in_flight` requests outstanding at all times, each completion submits next
+static double Bench_CallbacksSteady(std::size_t requests, std::size_t in_flight, std::size_t delay_ticks)
+{
+    struct State
+    {
+        CURL_Async curl_async = nullptr;
+        std::size_t started = 0;
+        std::size_t finished = 0;
+        std::size_t requests = 0;
+
+        static void on_response(void* user_data, std::string response)
+        {
+            State& self = *static_cast<State*>(user_data);
+            self.finished += response.size() ? 1 : 0;
+            if (self.started < self.requests)
+            {
+                ++self.started;
+                CURL_async_get(self.curl_async, kBench_Url, &self, &State::on_response);
+            }
+        }
+    };
+
+    CURL_FakeTransport transport{"content 1", delay_ticks};
+    CURL_Async curl_async = CURL_async_create(transport);
+    const double ns = Bench_NsPerOp(requests, [&]()
+    {
+        State state;
+        state.curl_async = curl_async;
+        state.requests = requests;
+        for (; state.started < in_flight; ++state.started)
+        {
+            CURL_async_get(curl_async, kBench_Url, &state, &State::on_response);
+        }
+        while (state.finished != requests)
+        {
+            CURL_async_tick(curl_async);
+        }
+        g_Bench_sink = state.finished;
+    });
+    CURL_async_destroy(curl_async);
+    return ns;
+}
+
+static Co_Task Bench_CoroWorker(CURL_Async curl_async, std::size_t requests, std::size_t& finished)
+{
+    for (std::size_t i = 0; i < requests; ++i)
+    {
+        const std::string response = co_await CURL_await_get(curl_async, kBench_Url);
+        finished += response.size() ? 1 : 0;
+    }
+}
+
+// `coroutines` coroutines, each awaits `requests / coroutines` times in a row
+static double Bench_Coroutines(std::size_t requests, std::size_t coroutines)
+{
+    CURL_FakeTransport transport{"content 1"};
+    CURL_Async curl_async = CURL_async_create(transport);
+    const double ns = Bench_NsPerOp(requests, [&]()
+    {
+        std::size_t finished = 0;
+        std::vector<Co_Task> tasks;
+        tasks.reserve(coroutines);
+        for (std::size_t i = 0; i < coroutines; ++i)
+        {
+            tasks.push_back(Bench_CoroWorker(curl_async, requests / coroutines, finished));
+            tasks.back().resume();
+        }
+        while (finished != requests)
+        {
+            CURL_async_tick(curl_async);
+        }
+        g_Bench_sink = finished;
+    });
+    CURL_async_destroy(curl_async);
+    return ns;
+}
+
+// hot path pieces, in isolation
+
+static double Bench_MapInsertFindErase(std::size_t ops, std::size_t in_flight)
+{
+    std::unordered_map<CURL_TransferId, std::function<void (CURL_TransferId)>> map;
+    std::vector<std::uint64_t> keys(in_flight + ops);
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        keys[i] = 0x1000 + i * 64; // pointer-like
+    }
+    const auto key = [&](std::size_t i)
+    {
+        return reinterpret_cast<CURL_TransferId>(static_cast<std::uintptr_t>(keys[i]));
+    };
+    return Bench_NsPerOp(ops, [&]()
+    {
+        map.clear();
+        for (std::size_t i = 0; i < in_flight; ++i)
+        {
+            map[key(i)] = [](CURL_TransferId) {};
+        }
+        for (std::size_t i = 0; i < ops; ++i)
+        {
+            map[key(in_flight + i)] = [](CURL_TransferId) {};
+            auto it = map.find(key(i));
+            g_Bench_sink = (it != map.end()) ? 1 : 0;
+            map.erase(it);
+        }
+    });
+}
+
+static double Bench_FunctionMakeCall(std::size_t ops)
+{
+    // same captures as CURL_async_get() lambda: 4 pointers, heap-allocated
+    void* a = &ops;
+    return Bench_NsPerOp(ops, [&]()
+    {
+        for (std::size_t i = 0; i < ops; ++i)
+        {
+            std::function<void (CURL_TransferId)> f = [a, b = a, c = a, d = i](CURL_TransferId t)
+            {
+                g_Bench_sink = reinterpret_cast<std::uintptr_t>(a) + reinterpret_cast<std::uintptr_t>(b)
+                    + reinterpret_cast<std::uintptr_t>(c) + d + reinterpret_cast<std::uintptr_t>(t);
+            };
+            f(nullptr);
+        }
+    });
+}
+
+static Co_Task Bench_Yielder(std::size_t& counter)
+{
+    while (true)
+    {
+        ++counter;
+        co_await std::suspend_always{};
+    }
+}
+
+static double Bench_CoroutineResume(std::size_t ops)
+{
+    std::size_t counter = 0;
+    Co_Task task = Bench_Yielder(counter);
+    return Bench_NsPerOp(ops, [&]()
+    {
+        for (std::size_t i = 0; i < ops; ++i)
+        {
+            task.resume();
+        }
+        g_Bench_sink = counter;
+    });
+}
+
+int main(int argc, char* argv[])
+{
+    // optional sanity check of the real transport, same API
+    if (argc > 1)
+    {
+        CURL_Async curl_async = CURL_async_create();
+        bool done = false;
+        CURL_async_get(curl_async, argv[1], &done
+            , [](void* user_data, std::string response)
+        {
+            std::println("real transport response: '{}'", response);
+            *static_cast<bool*>(user_data) = true;
+        });
+        while (!done)
+        {
+            CURL_async_tick(curl_async);
+        }
+        CURL_async_destroy(curl_async);
+    }
+
+    const std::size_t N = 100'000;
+    std::println("pure scheduler overhead, fake transport, per request:");
+    Bench_Report("callbacks, burst 1k, instant", Bench_CallbacksBurst(1'000, 0));
+    Bench_Report("callbacks, burst 100k, instant", Bench_CallbacksBurst(N, 0));
+    Bench_Report("callbacks, 1k in flight, 16 ticks delay", Bench_CallbacksSteady(N, 1'000, 16));
+    Bench_Report("callbacks, 10k in flight, 64 ticks delay", Bench_CallbacksSteady(N, 10'000, 64));
+    Bench_Report("coroutines, 1 x 100k awaits", Bench_Coroutines(N, 1));
+    Bench_Report("coroutines, 1k x 100 awaits", Bench_Coroutines(N, 1'000));
+    std::println("hot path pieces, per operation:");
+    Bench_Report("unordered_map insert+find+erase, 1k in map", Bench_MapInsertFindErase(N, 1'000));
+    Bench_Report("std::function make+call, 4 captures", Bench_FunctionMakeCall(N));
+    Bench_Report("coroutine resume+suspend", Bench_CoroutineResume(N));
+}
@@ -0,0 +1,703 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <charconv>
+#include <fstream>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// Open-loop (wrk2-style) HTTP load generator.
+// Requests are sent on a fixed schedule, independent of responses; latency
+// is measured from the *intended* send time, so when the target (or we)
+// can't keep up, queueing delay shows up in the numbers instead of being
+// silently skipped ("coordinated omission").
+// Sharded: one CURL_AsyncScheduler per thread, shard i of T sends the
+// requests number i, i + T, i + 2T, ... of the schedule.
+static const char kLoad_Usage[] =
+    "usage: 11_load_generator [options] url [url...]\n"
+    "  --rate R           requests per second, total (default 100)\n"
+    "  --duration S       seconds (default 10)\n"
+    "  --schedule SPEC    instead of --rate/--duration: comma-separated\n"
+    "                     RATE:SECONDS or FROM-TO:SECONDS (linear ramp),\n"
+    "                     e.g. 100:5,100-1000:10,1000:5\n"
+    "  --threads T        sending threads (default 1)\n"
+    "  --connections C    max connections, total (default 64)\n"
+    "  --timeout-ms MS    per request (default 10000)\n"
+    "  --urls FILE        read urls from FILE, one per line\n"
+    "  --hgrm FILE        write HdrHistogram percentile spectrum";
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+
+static size_t CURL_OnDiscardCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    (void)ptr;
+    (void)data;
+    return (size * nmemb);
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    // unlike samples, failed transfers are expected under load
+    using Callback = std::function<void (CURL* curl_easy, CURLcode result)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+    // sleeps in curl_multi_poll() until socket activity or timeout
+    void wait(std::chrono::milliseconds timeout);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        const CURLcode result = m->data.result;
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy, result);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+void CURL_AsyncScheduler::wait(std::chrono::milliseconds timeout)
+{
+    const CURLMcode status = curl_multi_poll(_multi_curl, nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    assert(status == CURLM_OK);
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+// HdrHistogram-like log-linear buckets, microseconds; 2^7 sub-buckets
+// per power of 2 (< 1% error). Single-threaded: each shard has its own,
+// merged at the end
+struct Load_Histogram
+{
+    static constexpr unsigned kSubBucketBits = 7;
+    static constexpr std::uint64_t kSubBuckets = (std::uint64_t{1} << kSubBucketBits);
+    // up to 2^36 us (~19 hours)
+    static constexpr unsigned kMaxValueBits = 36;
+    static constexpr std::size_t kBucketsCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+    static std::size_t bucket_index(std::uint64_t value)
+    {
+        value = std::min(value, (std::uint64_t{1} << kMaxValueBits) - 1);
+        if (value < kSubBuckets)
+        {
+            return static_cast<std::size_t>(value);
+        }
+        const unsigned msb = static_cast<unsigned>(std::bit_width(value)) - 1;
+        const unsigned shift = msb - kSubBucketBits;
+        const std::uint64_t sub = (value >> shift) - kSubBuckets;
+        return static_cast<std::size_t>(((shift + 1) * kSubBuckets) + sub);
+    }
+
+    // upper bound of values that land into the bucket
+    static std::uint64_t bucket_value(std::size_t index)
+    {
+        const std::uint64_t group = index / kSubBuckets;
+        const std::uint64_t sub = index % kSubBuckets;
+        if (group == 0)
+        {
+            return sub;
+        }
+        return (((kSubBuckets + sub + 1) << (group - 1)) - 1);
+    }
+
+    void record(std::uint64_t value)
+    {
+        ++_buckets[bucket_index(value)];
+        ++_count;
+        _max = std::max(_max, value);
+        _sum += static_cast<double>(value);
+        _sum_squares += static_cast<double>(value) * static_cast<double>(value);
+    }
+
+    void merge(const Load_Histogram& rhs)
+    {
+        for (std::size_t i = 0; i < kBucketsCount; ++i)
+        {
+            _buckets[i] += rhs._buckets[i];
+        }
+        _count += rhs._count;
+        _max = std::max(_max, rhs._max);
+        _sum += rhs._sum;
+        _sum_squares += rhs._sum_squares;
+    }
+
+    std::uint64_t value_at(double percentile) const
+    {
+        if (_count == 0)
+        {
+            return 0;
+        }
+        const std::uint64_t rank = std::max<std::uint64_t>(1
+            , static_cast<std::uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(_count))));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < kBucketsCount; ++i)
+        {
+            seen += _buckets[i];
+            if (seen >= rank)
+            {
+                return std::min(bucket_value(i), _max);
+            }
+        }
+        return _max;
+    }
+
+    double mean() const
+    {
+        return (_count > 0) ? (_sum / static_cast<double>(_count)) : 0.0;
+    }
+
+    std::vector<std::uint64_t> _buckets = std::vector<std::uint64_t>(kBucketsCount);
+    std::uint64_t _count = 0;
+    double stddev() const
+    {
+        if (_count == 0)
+        {
+            return 0.0;
+        }
+        const double m = mean();
+        return std::sqrt(std::max(0.0, _sum_squares / static_cast<double>(_count) - m * m));
+    }
+
+    std::uint64_t _max = 0;
+    double _sum = 0;
+    double _sum_squares = 0;
+};
+
+// piece of the rate schedule: linear from `from_rate` to `to_rate`
+struct Load_Segment
+{
+    double seconds = 0;
+    double from_rate = 0;
+    double to_rate = 0;
+};
+
+struct Load_Options
+{
+    std::vector<Load_Segment> schedule;
+    std::vector<std::string> urls;
+    unsigned threads = 1;
+    long connections = 64;
+    long timeout_ms = 10'000;
+    std::string hgrm_path;
+};
+
+static double Load_TotalSeconds(const std::vector<Load_Segment>& schedule)
+{
+    double seconds = 0;
+    for (const Load_Segment& segment : schedule)
+    {
+        seconds += segment.seconds;
+    }
+    return seconds;
+}
+
+// seconds since start when the schedule's cumulative request count
+// (integral of the rate) reaches `count`; negative past the end
+static double Load_TimeAtCount(const std::vector<Load_Segment>& schedule, double count)
+{
+    double elapsed = 0;
+    for (const Load_Segment& segment : schedule)
+    {
+        const double a = segment.from_rate;
+        const double total = 0.5 * (a + segment.to_rate) * segment.seconds;
+        if (count < total)
+        {   // a*t + k/2*t^2 = count, in a form stable for k == 0 and a == 0
+            if (count <= 0)
+            {   // also avoids 0/0 on a ramp starting from 0
+                return elapsed;
+            }
+            const double k = (segment.to_rate - a) / segment.seconds;
+            const double t = 2.0 * count / (a + std::sqrt(a * a + 2.0 * k * count));
+            return elapsed + t;
+        }
+        count -= total;
+        elapsed += segment.seconds;
+    }
+    return -1;
+}
+
+struct Load_Shard
+{
+    using Clock = std::chrono::steady_clock;
+
+    Load_Shard(const Load_Options& options, unsigned index);
+    ~Load_Shard();
+    // no copy, no move: `this` is captured by in-flight callbacks
+    Load_Shard(const Load_Shard&) = delete;
+
+    void run(Clock::time_point start);
+    void send(Clock::time_point intended);
+    void on_finish(CURL* curl_easy, CURLcode result
+        , Clock::time_point intended, Clock::time_point sent);
+
+    const Load_Options& _options;
+    unsigned _index = 0;
+    CURL_Async _curl_async = nullptr;
+    std::size_t _next_url = 0;
+    std::size_t _in_flight = 0;
+
+    // from intended send time: what a user of the target would see
+    Load_Histogram _latency;
+    // from actual send time: hides coordinated omission, for comparison
+    Load_Histogram _service_time;
+    std::uint64_t _sent = 0;
+    std::uint64_t _transport_errors = 0;
+    std::uint64_t _http_errors = 0;
+    // how late we were sending: generator itself is overloaded if large
+    std::uint64_t _max_send_lag_us = 0;
+};
+
+Load_Shard::Load_Shard(const Load_Options& options, unsigned index)
+    : _options{options}
+    , _index{index}
+{
+    _curl_async = CURL_async_create();
+    // per shard share of the connection limit; excess requests
+    // wait inside libcurl and that wait is part of the latency
+    const long connections = std::max(1L, _options.connections / static_cast<long>(_options.threads));
+    const CURLMcode status = curl_multi_setopt(CURL_scheduler(_curl_async)._multi_curl
+        , CURLMOPT_MAX_TOTAL_CONNECTIONS, connections);
+    assert(status == CURLM_OK);
+}
+
+Load_Shard::~Load_Shard()
+{
+    CURL_async_destroy(_curl_async);
+}
+
+void Load_Shard::run(Clock::time_point start)
+{
+    const double total_seconds = Load_TotalSeconds(_options.schedule);
+    const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(total_seconds));
+    // intended send time of this shard's k-th request: shards interleave
+    // over the global request sequence, each time is exact, no drift
+    const auto intended_at = [&](std::uint64_t k)
+    {
+        const double count = static_cast<double>(k) * _options.threads + _index;
+        const double seconds = Load_TimeAtCount(_options.schedule, count);
+        if (seconds < 0)
+        {
+            return end;
+        }
+        return start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(seconds));
+    };
+    std::uint64_t k = 0;
+    Clock::time_point next = intended_at(k);
+
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(_curl_async);
+    while (true)
+    {
+        const Clock::time_point now = Clock::now();
+        // open loop: catch up on everything that was due, even if late
+        while ((next <= now) && (next < end))
+        {
+            send(next);
+            next = intended_at(++k);
+        }
+        scheduler.tick();
+        if ((next >= end) && (_in_flight == 0))
+        {
+            break;
+        }
+        const auto until_next = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now());
+        const std::chrono::milliseconds timeout = (next >= end)
+            ? std::chrono::milliseconds{100}
+            : std::clamp(until_next, std::chrono::milliseconds{0}, std::chrono::milliseconds{100});
+        if (timeout.count() > 0)
+        {
+            scheduler.wait(timeout);
+        }
+    }
+}
+
+void Load_Shard::send(Clock::time_point intended)
+{
+    const std::string& url = _options.urls[_next_url];
+    _next_url = (_next_url + 1) % _options.urls.size();
+
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnDiscardCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_TIMEOUT_MS, _options.timeout_ms);
+    assert(status == CURLE_OK);
+
+    const Clock::time_point sent = Clock::now();
+    const std::uint64_t lag_us = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(sent - intended).count());
+    _max_send_lag_us = std::max(_max_send_lag_us, lag_us);
+    ++_sent;
+    ++_in_flight;
+    CURL_scheduler(_curl_async).add_request(curl_easy
+        , [this, intended, sent](CURL* curl_easy_, CURLcode result)
+    {
+        on_finish(curl_easy_, result, intended, sent);
+    });
+}
+
+void Load_Shard::on_finish(CURL* curl_easy, CURLcode result
+    , Clock::time_point intended, Clock::time_point sent)
+{
+    const Clock::time_point now = Clock::now();
+    --_in_flight;
+    long response_code = -1;
+    const CURLcode status = curl_easy_getinfo(curl_easy, CURLINFO_RESPONSE_CODE, &response_code);
+    assert(status == CURLE_OK);
+    curl_easy_cleanup(curl_easy);
+
+    if (result != CURLE_OK)
+    {   // timeouts and connection errors are not latency samples
+        ++_transport_errors;
+        return;
+    }
+    if ((response_code < 200) || (response_code >= 400))
+    {
+        ++_http_errors;
+    }
+    const auto us = [](Clock::duration duration)
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+    };
+    _latency.record(us(now - intended));
+    _service_time.record(us(now - sent));
+}
+
+static bool Load_ToNumber(std::string_view str, auto& number)
+{
+    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), number);
+    return (ec == std::errc{}) && (ptr == str.data() + str.size());
+}
+
+// "100:5,100-1000:10"
+static bool Load_ParseSchedule(std::string_view spec, std::vector<Load_Segment>& schedule)
+{
+    schedule.clear();
+    while (!spec.empty())
+    {
+        const std::size_t comma = spec.find(',');
+        const std::string_view part = spec.substr(0, comma);
+        spec = (comma == std::string_view::npos) ? std::string_view{} : spec.substr(comma + 1);
+
+        const std::size_t colon = part.find(':');
+        if (colon == std::string_view::npos)
+        {
+            return false;
+        }
+        const std::string_view rates = part.substr(0, colon);
+        const std::size_t dash = rates.find('-');
+        Load_Segment segment;
+        if (!Load_ToNumber(part.substr(colon + 1), segment.seconds)
+            || !Load_ToNumber(rates.substr(0, dash), segment.from_rate))
+        {
+            return false;
+        }
+        segment.to_rate = segment.from_rate;
+        if ((dash != std::string_view::npos) && !Load_ToNumber(rates.substr(dash + 1), segment.to_rate))
+        {
+            return false;
+        }
+        if ((segment.seconds <= 0) || (segment.from_rate < 0) || (segment.to_rate < 0))
+        {
+            return false;
+        }
+        schedule.push_back(segment);
+    }
+    return !schedule.empty();
+}
+
+static bool Load_ParseOptions(int argc, char* argv[], Load_Options& options)
+{
+    double rate = 100;
+    double duration = 10;
+    std::string schedule;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (!arg.starts_with("--"))
+        {
+            options.urls.emplace_back(arg);
+            continue;
+        }
+        if ((i + 1) >= argc)
+        {
+            return false;
+        }
+        const std::string_view value = argv[++i];
+        bool ok = true;
+        if (arg == "--rate")
+        {
+            ok = Load_ToNumber(value, rate) && (rate > 0);
+        }
+        else if (arg == "--duration")
+        {
+            ok = Load_ToNumber(value, duration) && (duration > 0);
+        }
+        else if (arg == "--schedule")
+        {
+            schedule = value;
+        }
+        else if (arg == "--threads")
+        {
+            ok = Load_ToNumber(value, options.threads) && (options.threads > 0);
+        }
+        else if (arg == "--connections")
+        {
+            ok = Load_ToNumber(value, options.connections) && (options.connections > 0);
+        }
+        else if (arg == "--timeout-ms")
+        {
+            ok = Load_ToNumber(value, options.timeout_ms) && (options.timeout_ms > 0);
+        }
+        else if (arg == "--urls")
+        {
+            std::ifstream file{std::string(value)};
+            ok = bool(file);
+            for (std::string line; std::getline(file, line); )
+            {
+                while (!line.empty() && ((line.back() == '\r') || (line.back() == ' ')))
+                {
+                    line.pop_back();
+                }
+                if (!line.empty() && !line.starts_with('#'))
+                {
+                    options.urls.push_back(std::move(line));
+                }
+            }
+        }
+        else if (arg == "--hgrm")
+        {
+            options.hgrm_path = value;
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    if (schedule.empty())
+    {
+        options.schedule = {Load_Segment{duration, rate, rate}};
+    }
+    else if (!Load_ParseSchedule(schedule, options.schedule))
+    {
+        return false;
+    }
+    return !options.urls.empty();
+}
+
+static void Load_PrintPercentiles(const char* title, const Load_Histogram& histogram)
+{
+    std::println("{} (us): mean {:.0f}, max {}", title, histogram.mean(), histogram._max);
+    for (const double p : {50.0, 75.0, 90.0, 99.0, 99.9, 99.99, 99.999, 100.0})
+    {
+        std::println("  {:>8.3f}% {:>12}", p, histogram.value_at(p));
+    }
+}
+
+// HdrHistogram "percentile distribution" text format, as wrk2 prints it;
+// plot with hdrhistogram.github.io/HdrHistogram/plotFiles.html
+static bool Load_WriteHgrm(const std::string& path, const Load_Histogram& histogram)
+{
+    std::ofstream out{path, std::ios::trunc};
+    if (!out)
+    {
+        return false;
+    }
+    out << "       Value     Percentile TotalCount 1/(1-Percentile)\n\n";
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < Load_Histogram::kBucketsCount; ++i)
+    {
+        if (histogram._buckets[i] == 0)
+        {
+            continue;
+        }
+        seen += histogram._buckets[i];
+        const double fraction = static_cast<double>(seen) / static_cast<double>(histogram._count);
+        const double value_ms = static_cast<double>(std::min(Load_Histogram::bucket_value(i), histogram._max)) / 1000.0;
+        char line[128]{};
+        if (fraction < 1.0)
+        {
+            std::snprintf(line, sizeof(line), "%12.3f %14.12f %10llu %14.2f\n"
+                , value_ms, fraction, static_cast<unsigned long long>(seen), 1.0 / (1.0 - fraction));
+        }
+        else
+        {
+            std::snprintf(line, sizeof(line), "%12.3f %14.12f %10llu\n"
+                , value_ms, fraction, static_cast<unsigned long long>(seen));
+        }
+        out << line;
+    }
+    char footer[256]{};
+    std::snprintf(footer, sizeof(footer)
+        , "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n#[Max     = %12.3f, Total count    = %12llu]\n"
+        , histogram.mean() / 1000.0, histogram.stddev() / 1000.0, static_cast<double>(histogram._max) / 1000.0
+        , static_cast<unsigned long long>(histogram._count));
+    out << footer;
+    return bool(out);
+}
+
+int main(int argc, char* argv[])
+{
+    Load_Options options;
+    if (!Load_ParseOptions(argc, argv, options))
+    {
+        std::println(stderr, "{}", kLoad_Usage);
+        return 1;
+    }
+    // shards create their schedulers on this thread:
+    // curl_global_init() is not thread-safe on older libcurl
+    std::vector<std::unique_ptr<Load_Shard>> shards;
+    for (unsigned i = 0; i < options.threads; ++i)
+    {
+        shards.push_back(std::make_unique<Load_Shard>(options, i));
+    }
+
+    const double seconds = Load_TotalSeconds(options.schedule);
+    std::println("{} url(s), {} thread(s), {} connection(s), {:.1f} s"
+        , options.urls.size(), options.threads, options.connections, seconds);
+    // a bit in the future: all threads are up by then
+    const Load_Shard::Clock::time_point start = Load_Shard::Clock::now() + std::chrono::milliseconds{50};
+    {
+        std::vector<std::jthread> threads;
+        for (std::unique_ptr<Load_Shard>& shard : shards)
+        {
+            threads.emplace_back([&shard, start]()
+            {
+                shard->run(start);
+            });
+        }
+    }
+    const double elapsed = std::chrono::duration<double>(Load_Shard::Clock::now() - start).count();
+
+    Load_Histogram latency;
+    Load_Histogram service_time;
+    std::uint64_t sent = 0;
+    std::uint64_t transport_errors = 0;
+    std::uint64_t http_errors = 0;
+    std::uint64_t max_send_lag_us = 0;
+    for (const std::unique_ptr<Load_Shard>& shard : shards)
+    {
+        latency.merge(shard->_latency);
+        service_time.merge(shard->_service_time);
+        sent += shard->_sent;
+        transport_errors += shard->_transport_errors;
+        http_errors += shard->_http_errors;
+        max_send_lag_us = std::max(max_send_lag_us, shard->_max_send_lag_us);
+    }
+    shards.clear();
+
+    std::println("sent {} requests in {:.2f} s, {:.1f} req/s achieved", sent, elapsed
+        , static_cast<double>(latency._count) / elapsed);
+    std::println("errors: {} transport (connect/timeout), {} http status", transport_errors, http_errors);
+    std::println("max send lag {} us{}", max_send_lag_us
+        , (max_send_lag_us > 10'000) ? " - generator is saturated, add --threads" : "");
+    Load_PrintPercentiles("latency, from intended send time", latency);
+    Load_PrintPercentiles("service time, from actual send time", service_time);
+    if (!options.hgrm_path.empty())
+    {
+        const bool ok = Load_WriteHgrm(options.hgrm_path, latency);
+        std::println("{} {}", ok ? "written" : "failed to write", options.hgrm_path);
+    }
+    return ((transport_errors + http_errors) == 0) ? 0 : 2;
+}
@@ -0,0 +1,632 @@
+#include <print>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+#include <new>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// libcurl bookkeeping;
+// everything, except tick() and wait(), is safe to call from any thread
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+// sleeps in curl_multi_poll() until socket activity, new request or timeout
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout);
+
+// future/promise API
+struct CURL_Future;
+CURL_Future CURL_future_get(CURL_Async curl_async, const std::string& url);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+struct CURL_FuturePool;
+
+// Shared state of one promise/future pair. Unlike std::future, which
+// allocates it and guards it with mutex + condition variable, it comes
+// from a pool and is published with a single atomic: the producer writes
+// the response, then sets kReady; consumer checks kReady with acquire.
+struct CURL_FutureState
+{
+    static constexpr std::uint32_t kReady        = 1u << 0;
+    static constexpr std::uint32_t kContinuation = 1u << 1;
+    // consumer is (about to be) parked in get(): producer must notify
+    static constexpr std::uint32_t kWaiting      = 1u << 2;
+
+    // type-erased .then() callable, stored inline
+    static constexpr std::size_t kContinuationSize = 6 * sizeof(void*);
+    using Invoke = void (*)(void* storage, std::string&& response);
+
+    // one for the promise, one for the future
+    void release();
+
+    std::atomic<std::uint32_t> _flags{0};
+    std::atomic<std::uint32_t> _refs{0};
+    std::string _response;
+    Invoke _invoke = nullptr;
+    alignas(std::max_align_t) unsigned char _storage[kContinuationSize]{};
+    CURL_FuturePool* _pool = nullptr;
+    // pool bookkeeping: 1-based index of next free slot
+    std::atomic<std::uint32_t> _next_free{0};
+};
+
+// Fixed number of states, recycled through a lock-free stack (Treiber,
+// index + tag against ABA); heap fallback when all are in use
+struct CURL_FuturePool
+{
+    explicit CURL_FuturePool(std::uint32_t capacity);
+    // no copy, no move: states point back to the pool
+    CURL_FuturePool(const CURL_FuturePool&) = delete;
+
+    CURL_FutureState* acquire();
+    void release(CURL_FutureState* state);
+
+    static std::uint64_t pack(std::uint32_t tag, std::uint32_t index)
+    {
+        return ((std::uint64_t{tag} << 32) | index);
+    }
+
+    std::unique_ptr<CURL_FutureState[]> _states;
+    std::uint32_t _capacity = 0;
+    // (tag << 32) | 1-based index of the top; 0 index = empty
+    std::atomic<std::uint64_t> _head{0};
+};
+
+CURL_FuturePool::CURL_FuturePool(std::uint32_t capacity)
+    : _states{std::make_unique<CURL_FutureState[]>(capacity)}
+    , _capacity{capacity}
+{
+    for (std::uint32_t i = 0; i < capacity; ++i)
+    {
+        _states[i]._pool = this;
+        _states[i]._next_free.store((i + 1 < capacity) ? (i + 2) : 0, std::memory_order_relaxed);
+    }
+    _head.store(pack(0, (capacity > 0) ? 1 : 0), std::memory_order_relaxed);
+}
+
+CURL_FutureState* CURL_FuturePool::acquire()
+{
+    CURL_FutureState* state = nullptr;
+    std::uint64_t head = _head.load(std::memory_order_acquire);
+    while (true)
+    {
+        const std::uint32_t index = static_cast<std::uint32_t>(head);
+        if (index == 0)
+        {   // exhausted
+            state = new CURL_FutureState{};
+            state->_pool = nullptr;
+            break;
+        }
+        CURL_FutureState& top = _states[index - 1];
+        const std::uint32_t next = top._next_free.load(std::memory_order_relaxed);
+        const std::uint32_t tag = static_cast<std::uint32_t>(head >> 32) + 1;
+        if (_head.compare_exchange_weak(head, pack(tag, next)
+            , std::memory_order_acquire, std::memory_order_acquire))
+        {
+            state = &top;
+            break;
+        }
+    }
+    state->_flags.store(0, std::memory_order_relaxed);
+    state->_refs.store(2, std::memory_order_relaxed);
+    // keeps capacity: steady state does not allocate for small responses
+    state->_response.clear();
+    state->_invoke = nullptr;
+    return state;
+}
+
+void CURL_FuturePool::release(CURL_FutureState* state)
+{
+    const std::uint32_t index = static_cast<std::uint32_t>(state - _states.get()) + 1;
+    assert((index >= 1) && (index <= _capacity));
+    std::uint64_t head = _head.load(std::memory_order_relaxed);
+    while (true)
+    {
+        state->_next_free.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+        const std::uint32_t tag = static_cast<std::uint32_t>(head >> 32) + 1;
+        if (_head.compare_exchange_weak(head, pack(tag, index)
+            , std::memory_order_release, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+void CURL_FutureState::release()
+{
+    if (_refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+        return;
+    }
+    if (_pool)
+    {
+        _pool->release(this);
+    }
+    else
+    {
+        delete this;
+    }
+}
+
+// producer side, owned by the scheduler. Move-only: a single owner
+// fulfills the shared state exactly once
+struct CURL_Promise
+{
+    CURL_Promise() = default;
+    explicit CURL_Promise(CURL_FutureState* state)
+        : _state{state} {}
+    CURL_Promise(CURL_Promise&& rhs) noexcept
+        : _state{std::exchange(rhs._state, nullptr)} {}
+    CURL_Promise& operator=(CURL_Promise&& rhs) noexcept
+    {
+        assert(!_state);
+        _state = std::exchange(rhs._state, nullptr);
+        return *this;
+    }
+    CURL_Promise(const CURL_Promise&) = delete;
+    CURL_Promise& operator=(const CURL_Promise&) = delete;
+    ~CURL_Promise() noexcept
+    {
+        // broken promise: the future would wait forever
+        assert(!_state);
+    }
+
+    void set_value(std::string response)
+    {
+        assert(_state);
+        CURL_FutureState& state = *_state;
+        state._response = std::move(response);
+        // release: response is visible to whoever observes kReady
+        const std::uint32_t prev = state._flags.fetch_or(CURL_FutureState::kReady, std::memory_order_acq_rel);
+        if (prev & CURL_FutureState::kContinuation)
+        {   // .then() came first, run it here, on producer thread
+            state._invoke(state._storage, std::move(state._response));
+        }
+        else if (prev & CURL_FutureState::kWaiting)
+        {
+            state._flags.notify_all();
+        }
+        std::exchange(_state, nullptr)->release();
+    }
+
+    CURL_FutureState* _state = nullptr;
+};
+
+struct CURL_Future
+{
+    CURL_Future() = default;
+    explicit CURL_Future(CURL_FutureState* state)
+        : _state{state} {}
+    CURL_Future(CURL_Future&& rhs) noexcept
+        : _state{std::exchange(rhs._state, nullptr)} {}
+    CURL_Future& operator=(CURL_Future&& rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            reset();
+            _state = std::exchange(rhs._state, nullptr);
+        }
+        return *this;
+    }
+    CURL_Future(const CURL_Future&) = delete;
+    ~CURL_Future() noexcept
+    {
+        reset();
+    }
+
+    bool valid() const
+    {
+        return (_state != nullptr);
+    }
+
+    // non-blocking, polling-style check
+    bool is_ready() const
+    {
+        assert(_state);
+        return (_state->_flags.load(std::memory_order_acquire) & CURL_FutureState::kReady);
+    }
+
+    // blocks (futex via std::atomic::wait) until ready; consumes the future.
+    // some other thread must be ticking the scheduler
+    std::string get()
+    {
+        assert(_state);
+        std::uint32_t flags = _state->_flags.load(std::memory_order_acquire);
+        while (!(flags & CURL_FutureState::kReady))
+        {
+            flags = _state->_flags.fetch_or(CURL_FutureState::kWaiting, std::memory_order_acq_rel)
+                | CURL_FutureState::kWaiting;
+            if (flags & CURL_FutureState::kReady)
+            {
+                break;
+            }
+            _state->_flags.wait(flags, std::memory_order_acquire);
+            flags = _state->_flags.load(std::memory_order_acquire);
+        }
+        std::string response = std::move(_state->_response);
+        reset();
+        return response;
+    }
+
+    // `f(std::string)` runs exactly once: right here if already ready,
+    // otherwise on the thread that completes the request; consumes the future
+    template<typename F>
+    void then(F&& f)
+    {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= CURL_FutureState::kContinuationSize, "continuation is too big");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t));
+        assert(_state);
+        CURL_FutureState& state = *_state;
+        ::new (static_cast<void*>(state._storage)) Fn(std::forward<F>(f));
+        state._invoke = [](void* storage, std::string&& response)
+        {
+            Fn& fn = *std::launder(static_cast<Fn*>(storage));
+            fn(std::move(response));
+            fn.~Fn();
+        };
+        const std::uint32_t prev = state._flags.fetch_or(CURL_FutureState::kContinuation, std::memory_order_acq_rel);
+        if (prev & CURL_FutureState::kReady)
+        {
+            state._invoke(state._storage, std::move(state._response));
+        }
+        reset();
+    }
+
+    void reset()
+    {
+        if (_state)
+        {
+            std::exchange(_state, nullptr)->release();
+        }
+    }
+
+    CURL_FutureState* _state = nullptr;
+};
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    // move-only, so completion callbacks can own a CURL_Promise
+    using Callback = std::move_only_function<void (CURL* curl_easy)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+    // from any thread: handed to libcurl on the next tick()
+    void submit(std::string url, CURL_Promise promise);
+    void start_request(std::string url, CURL_Promise promise);
+
+    struct Submitted
+    {
+        std::string url;
+        CURL_Promise promise;
+    };
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+    CURL_FuturePool _pool{1024};
+    std::mutex _submitted_mutex;
+    std::vector<Submitted> _submitted;
+    // swapped with _submitted under the lock, processed outside
+    std::vector<Submitted> _to_start;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    {
+        std::lock_guard lock{_submitted_mutex};
+        _to_start.swap(_submitted);
+    }
+    for (Submitted& submitted : _to_start)
+    {
+        start_request(std::move(submitted.url), std::move(submitted.promise));
+    }
+    _to_start.clear();
+
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+void CURL_AsyncScheduler::submit(std::string url, CURL_Promise promise)
+{
+    {
+        std::lock_guard lock{_submitted_mutex};
+        _submitted.push_back(Submitted{std::move(url), std::move(promise)});
+    }
+    // thread-safe: interrupts curl_multi_poll() in CURL_async_wait()
+    const CURLMcode status = curl_multi_wakeup(_multi_curl);
+    assert(status == CURLM_OK);
+}
+
+void CURL_AsyncScheduler::start_request(std::string url, CURL_Promise promise)
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data directly into shared state
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, &promise._state->_response);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    add_request(curl_easy, [promise = std::move(promise)](CURL* curl_easy_) mutable
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        // not yet published: only we touch _response
+        promise.set_value(std::move(promise._state->_response));
+    });
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout)
+{
+    const CURLMcode status = curl_multi_poll(CURL_scheduler(curl_async)._multi_curl
+        , nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    assert(status == CURLM_OK);
+}
+
+CURL_Future CURL_future_get(CURL_Async curl_async, const std::string& url)
+{
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(curl_async);
+    CURL_FutureState* state = scheduler._pool.acquire();
+    scheduler.submit(url, CURL_Promise{state});
+    return CURL_Future{state};
+}
+
+// std::promise/std::future vs CURL_Promise/CURL_Future, no network
+using Bench_Clock = std::chrono::steady_clock;
+
+template<typename F>
+static double Bench_NsPerOp(std::size_t ops, F&& body)
+{
+    double best = 1e300;
+    for (int i = 0; i < 5; ++i)
+    {
+        const Bench_Clock::time_point start = Bench_Clock::now();
+        body();
+        const std::chrono::duration<double, std::nano> elapsed = Bench_Clock::now() - start;
+        best = std::min(best, elapsed.count() / static_cast<double>(ops));
+    }
+    return best;
+}
+
+static void Bench_Futures()
+{
+    const std::size_t N = 200'000;
+    CURL_FuturePool pool{1024};
+    std::size_t sink = 0;
+
+    // make pair, set value, get: all on one thread
+    const double std_local = Bench_NsPerOp(N, [&]()
+    {
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            std::promise<std::string> promise;
+            std::future<std::string> future = promise.get_future();
+            promise.set_value("content 1");
+            sink += future.get().size();
+        }
+    });
+    const double curl_local = Bench_NsPerOp(N, [&]()
+    {
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            CURL_FutureState* state = pool.acquire();
+            CURL_Future future{state};
+            CURL_Promise{state}.set_value("content 1");
+            sink += future.get().size();
+        }
+    });
+    const double curl_then = Bench_NsPerOp(N, [&]()
+    {
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            CURL_FutureState* state = pool.acquire();
+            CURL_Future{state}.then([&sink](std::string response)
+            {
+                sink += response.size();
+            });
+            CURL_Promise{state}.set_value("content 1");
+        }
+    });
+
+    // producer thread fulfills, consumer blocks in get() one by one
+    const std::size_t M = 20'000;
+    const double std_cross = Bench_NsPerOp(M, [&]()
+    {
+        std::vector<std::promise<std::string>> promises(M);
+        std::vector<std::future<std::string>> futures;
+        futures.reserve(M);
+        for (std::promise<std::string>& promise : promises)
+        {
+            futures.push_back(promise.get_future());
+        }
+        std::jthread producer{[&]()
+        {
+            for (std::promise<std::string>& promise : promises)
+            {
+                promise.set_value("content 1");
+            }
+        }};
+        for (std::future<std::string>& future : futures)
+        {
+            sink += future.get().size();
+        }
+    });
+    CURL_FuturePool cross_pool{static_cast<std::uint32_t>(M)};
+    const double curl_cross = Bench_NsPerOp(M, [&]()
+    {
+        std::vector<CURL_FutureState*> states(M);
+        std::vector<CURL_Future> futures;
+        futures.reserve(M);
+        for (CURL_FutureState*& state : states)
+        {
+            state = cross_pool.acquire();
+            futures.emplace_back(state);
+        }
+        std::jthread producer{[&]()
+        {
+            for (CURL_FutureState* state : states)
+            {
+                CURL_Promise{state}.set_value("content 1");
+            }
+        }};
+        for (CURL_Future& future : futures)
+        {
+            sink += future.get().size();
+        }
+    });
+
+    std::println("{:<36} {:>12} {:>12}", "ns per future", "std::future", "CURL_Future");
+    std::println("{:<36} {:>12.1f} {:>12.1f}", "make + set + get, same thread", std_local, curl_local);
+    std::println("{:<36} {:>12} {:>12.1f}", "make + then + set, same thread", "-", curl_then);
+    std::println("{:<36} {:>12.1f} {:>12.1f}", "set on producer, get on consumer", std_cross, curl_cross);
+    assert(sink > 0);
+}
+
+int main()
+{
+    CURL_Async curl_async = CURL_async_create();
+
+    // 1. async polling future: this thread ticks and polls
+    CURL_Future polled = CURL_future_get(curl_async, "localhost:5001/file1.txt");
+    while (!polled.is_ready())
+    {
+        CURL_async_tick(curl_async);
+    }
+    std::println("polled response: '{}'", polled.get());
+
+    // 2. blocking future: network loop on a separate thread
+    std::jthread loop{[curl_async](std::stop_token stop)
+    {
+        while (!stop.stop_requested())
+        {
+            CURL_async_wait(curl_async, std::chrono::milliseconds{100});
+            CURL_async_tick(curl_async);
+        }
+    }};
+    CURL_Future blocking = CURL_future_get(curl_async, "localhost:5001/file1.txt");
+    std::println("blocking response: '{}'", blocking.get());
+
+    // 3. continuation, runs on the loop thread
+    std::atomic<bool> done{false};
+    CURL_future_get(curl_async, "localhost:5001/file1.txt").then([&done](std::string response)
+    {
+        std::println("then response: '{}'", response);
+        done.store(true);
+        done.notify_one();
+    });
+    done.wait(false);
+
+    loop.request_stop();
+    loop.join();
+    CURL_async_destroy(curl_async);
+
+    Bench_Futures();
+}
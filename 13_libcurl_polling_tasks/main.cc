@@ -0,0 +1,396 @@
+#include <print>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <limits>
+#include <cstdint>
+#include <cstdlib>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+
+// polling tasks API: generational index into the scheduler's slot array;
+// a handle outlives its task safely - polling it reports Stale
+struct CURL_TaskId
+{
+    std::uint32_t index = std::numeric_limits<std::uint32_t>::max();
+    std::uint32_t generation = 0;
+};
+
+enum class CURL_TaskStatus
+{
+    Stale,   // unknown, already consumed or cancelled task
+    Running,
+    Done,
+};
+
+CURL_TaskId CURL_task_start(CURL_Async curl_async, const std::string& url);
+// on Done, response is swapped into `response` and the task is released;
+// pass the same string back next time to keep its capacity
+CURL_TaskStatus CURL_task_poll(CURL_Async curl_async, CURL_TaskId task, std::string& response);
+void CURL_task_cancel(CURL_Async curl_async, CURL_TaskId task);
+
+// only our side: libcurl still does its own malloc() per transfer
+static std::atomic<std::uint64_t> g_App_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    g_App_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+// One task; slots are never erased, only recycled, so the easy handle
+// and response capacity survive between tasks
+struct CURL_TaskSlot
+{
+    static constexpr std::uint32_t kNoFree = std::numeric_limits<std::uint32_t>::max();
+
+    enum class State : std::uint8_t { Free, Running, Done };
+
+    CURL* curl_easy = nullptr;
+    std::string response;
+    // bumped on release: invalidates every CURL_TaskId issued before
+    std::uint32_t generation = 0;
+    std::uint32_t next_free = kNoFree;
+    State state = State::Free;
+};
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    void tick();
+    CURL_TaskId start(const std::string& url);
+    CURL_TaskStatus poll(CURL_TaskId task, std::string& response);
+    void cancel(CURL_TaskId task);
+    // nullptr for stale id
+    CURL_TaskSlot* find(CURL_TaskId task);
+    void release(std::uint32_t index);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    // contiguous, indexed by CURL_TaskId::index; no hashing on poll
+    std::vector<CURL_TaskSlot> _slots;
+    std::uint32_t _free_head = CURL_TaskSlot::kNoFree;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    for (CURL_TaskSlot& slot : _slots)
+    {
+        if (slot.state == CURL_TaskSlot::State::Running)
+        {
+            const CURLMcode status = curl_multi_remove_handle(_multi_curl, slot.curl_easy);
+            assert(status == CURLM_OK);
+        }
+        if (slot.curl_easy)
+        {
+            curl_easy_cleanup(slot.curl_easy);
+        }
+    }
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        // slot index instead of callbacks map lookup
+        char* private_data = nullptr;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy, CURLINFO_PRIVATE, &private_data);
+        assert(status_ == CURLE_OK);
+        const std::uintptr_t index = reinterpret_cast<std::uintptr_t>(private_data);
+        assert(index < _slots.size());
+        CURL_TaskSlot& slot = _slots[index];
+        assert(slot.curl_easy == curl_easy);
+        assert(slot.state == CURL_TaskSlot::State::Running);
+        long response_code = -1;
+        const CURLcode status__ = curl_easy_getinfo(curl_easy, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status__ == CURLE_OK);
+        assert(response_code == 200L);
+        slot.state = CURL_TaskSlot::State::Done;
+    }
+}
+
+CURL_TaskId CURL_AsyncScheduler::start(const std::string& url)
+{
+    std::uint32_t index = _free_head;
+    if (index == CURL_TaskSlot::kNoFree)
+    {   // grows only until the peak number of simultaneous tasks is reached
+        index = static_cast<std::uint32_t>(_slots.size());
+        const CURL_TaskSlot* old_data = _slots.data();
+        _slots.emplace_back();
+        if (_slots.data() != old_data)
+        {   // relocated: re-point running transfers to their new response
+            for (CURL_TaskSlot& slot : _slots)
+            {
+                if (slot.state != CURL_TaskSlot::State::Running)
+                {
+                    continue;
+                }
+                const CURLcode status = curl_easy_setopt(slot.curl_easy, CURLOPT_WRITEDATA, &slot.response);
+                assert(status == CURLE_OK);
+            }
+        }
+    }
+    else
+    {
+        _free_head = _slots[index].next_free;
+    }
+    CURL_TaskSlot& slot = _slots[index];
+    assert(slot.state == CURL_TaskSlot::State::Free);
+
+    // 1. setup (or reuse) curl easy handle
+    if (slot.curl_easy)
+    {
+        curl_easy_reset(slot.curl_easy);
+    }
+    else
+    {
+        slot.curl_easy = curl_easy_init();
+        assert(slot.curl_easy);
+    }
+    CURL* curl_easy = slot.curl_easy;
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_PRIVATE, reinterpret_cast<void*>(std::uintptr_t{index}));
+    assert(status == CURLE_OK);
+
+    // 2. write response data directly into the slot
+    slot.response.clear();
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, &slot.response);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    const CURLMcode status_ = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status_ == CURLM_OK);
+    slot.state = CURL_TaskSlot::State::Running;
+    return CURL_TaskId{index, slot.generation};
+}
+
+CURL_TaskSlot* CURL_AsyncScheduler::find(CURL_TaskId task)
+{
+    if (task.index >= _slots.size())
+    {
+        return nullptr;
+    }
+    CURL_TaskSlot& slot = _slots[task.index];
+    if ((slot.generation != task.generation) || (slot.state == CURL_TaskSlot::State::Free))
+    {
+        return nullptr;
+    }
+    return &slot;
+}
+
+CURL_TaskStatus CURL_AsyncScheduler::poll(CURL_TaskId task, std::string& response)
+{
+    CURL_TaskSlot* slot = find(task);
+    if (!slot)
+    {
+        return CURL_TaskStatus::Stale;
+    }
+    if (slot->state == CURL_TaskSlot::State::Running)
+    {
+        return CURL_TaskStatus::Running;
+    }
+    // caller's old buffer goes back to the slot for the next task
+    response.swap(slot->response);
+    release(task.index);
+    return CURL_TaskStatus::Done;
+}
+
+void CURL_AsyncScheduler::cancel(CURL_TaskId task)
+{
+    CURL_TaskSlot* slot = find(task);
+    if (!slot)
+    {
+        return;
+    }
+    if (slot->state == CURL_TaskSlot::State::Running)
+    {
+        const CURLMcode status = curl_multi_remove_handle(_multi_curl, slot->curl_easy);
+        assert(status == CURLM_OK);
+    }
+    release(task.index);
+}
+
+void CURL_AsyncScheduler::release(std::uint32_t index)
+{
+    CURL_TaskSlot& slot = _slots[index];
+    slot.state = CURL_TaskSlot::State::Free;
+    ++slot.generation;
+    slot.next_free = _free_head;
+    _free_head = index;
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+CURL_TaskId CURL_task_start(CURL_Async curl_async, const std::string& url)
+{
+    return CURL_scheduler(curl_async).start(url);
+}
+
+CURL_TaskStatus CURL_task_poll(CURL_Async curl_async, CURL_TaskId task, std::string& response)
+{
+    return CURL_scheduler(curl_async).poll(task, response);
+}
+
+void CURL_task_cancel(CURL_Async curl_async, CURL_TaskId task)
+{
+    CURL_scheduler(curl_async).cancel(task);
+}
+
+// game-loop style: start a batch, then every frame tick once and poll all
+struct App_Tasks
+{
+    std::vector<CURL_TaskId> tasks;
+    std::vector<std::string> responses;
+    std::size_t done = 0;
+    std::size_t bytes = 0;
+};
+
+static std::size_t App_RunBatch(CURL_Async curl_async, App_Tasks& app, const std::string& url)
+{
+    for (CURL_TaskId& task : app.tasks)
+    {
+        task = CURL_task_start(curl_async, url);
+    }
+    app.done = 0;
+    std::size_t frames = 0;
+    while (app.done < app.tasks.size())
+    {
+        CURL_async_tick(curl_async);
+        ++frames;
+        for (std::size_t i = 0; i < app.tasks.size(); ++i)
+        {
+            std::string& response = app.responses[i];
+            if (CURL_task_poll(curl_async, app.tasks[i], response) == CURL_TaskStatus::Done)
+            {
+                app.bytes += response.size();
+                ++app.done;
+            }
+        }
+    }
+    return frames;
+}
+
+int main()
+{
+    CURL_Async curl_async = CURL_async_create();
+
+    // 1. single task
+    std::string response;
+    const CURL_TaskId task = CURL_task_start(curl_async, "localhost:5001/file1.txt");
+    while (CURL_task_poll(curl_async, task, response) != CURL_TaskStatus::Done)
+    {
+        CURL_async_tick(curl_async);
+    }
+    std::println("async response: '{}'", response);
+    // consumed: the same id is now detected as stale, even after slot reuse
+    const CURL_TaskId reused = CURL_task_start(curl_async, "localhost:5001/file1.txt");
+    assert(reused.index == task.index);
+    assert(CURL_task_poll(curl_async, task, response) == CURL_TaskStatus::Stale);
+    CURL_task_cancel(curl_async, reused);
+    assert(CURL_task_poll(curl_async, reused, response) == CURL_TaskStatus::Stale);
+
+    // 2. many tasks, polled every frame; 1st batch warms slots and buffers
+    const std::size_t kTasks = 256;
+    const std::string url = "localhost:5001/file1.txt";
+    App_Tasks app;
+    app.tasks.resize(kTasks);
+    app.responses.resize(kTasks);
+    const std::size_t warm_frames = App_RunBatch(curl_async, app, url);
+    const std::uint64_t allocations = g_App_allocations.load(std::memory_order_relaxed);
+    const std::size_t frames = App_RunBatch(curl_async, app, url);
+    const std::uint64_t steady = g_App_allocations.load(std::memory_order_relaxed) - allocations;
+
+    CURL_async_destroy(curl_async);
+
+    std::println("tasks: {} x 2, frames: {} + {}, bytes: {}", kTasks, warm_frames, frames, app.bytes);
+    std::println("allocations in steady state batch: {}", steady);
+}
@@ -0,0 +1,296 @@
+#include <print>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <new>
+#include <algorithm>
+#include <iterator>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+// drives transfers; finished ones are queued, no user code runs here
+void CURL_async_tick(CURL_Async curl_async);
+// sleeps in curl_multi_poll() until socket activity or timeout
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout);
+
+// completion queue API (pull model, similar to io_uring CQ/IOCP)
+struct CURL_Completion
+{
+    void* user_data = nullptr;
+    CURLcode result = CURLE_OK;
+    long response_code = -1;
+    // swapped with the queue's buffer: the record's previous response goes
+    // back to the queue and receives a later request's data, so reusing
+    // the same records keeps allocations out of steady state
+    std::string response;
+};
+
+void CURL_async_submit(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data);
+// moves up to `capacity` finished requests into `completions`;
+// returns how many were written
+std::size_t CURL_async_poll_completions(CURL_Async curl_async
+    , CURL_Completion* completions
+    , std::size_t capacity);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+// in-flight request, found back via CURLOPT_PRIVATE
+struct CURL_Request
+{
+    void* user_data = nullptr;
+    std::string response;
+};
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    void tick();
+    void submit(const std::string& url, void* user_data);
+    std::size_t poll_completions(CURL_Completion* completions, std::size_t capacity);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    // completion queue: [_completed_head, _completed_size) not yet polled;
+    // records past _completed_size are kept, holding callers' old buffers
+    std::vector<CURL_Completion> _completed;
+    std::size_t _completed_head = 0;
+    std::size_t _completed_size = 0;
+    // empty, with capacity; handed to new requests as their WRITEDATA
+    std::vector<std::string> _free_buffers;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        const CURLcode result = m->data.result;
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        char* private_data = nullptr;
+        CURLcode status_ = curl_easy_getinfo(curl_easy, CURLINFO_PRIVATE, &private_data);
+        assert(status_ == CURLE_OK);
+        CURL_Request* request = reinterpret_cast<CURL_Request*>(private_data);
+        assert(request);
+        long response_code = -1;
+        status_ = curl_easy_getinfo(curl_easy, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        curl_easy_cleanup(curl_easy);
+
+        // just a record; the caller decides when and where to process it
+        if (_completed_size == _completed.size())
+        {
+            (void)_completed.emplace_back();
+        }
+        CURL_Completion& completion = _completed[_completed_size++];
+        completion.user_data = request->user_data;
+        completion.result = result;
+        completion.response_code = response_code;
+        completion.response.swap(request->response);
+        // the record's old buffer, given back by poll_completions()
+        if (request->response.capacity() > 0)
+        {
+            request->response.clear();
+            _free_buffers.push_back(std::move(request->response));
+        }
+        delete request;
+    }
+}
+
+void CURL_AsyncScheduler::submit(const std::string& url, void* user_data)
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to the request
+    CURL_Request* request = new CURL_Request{};
+    request->user_data = user_data;
+    if (!_free_buffers.empty())
+    {
+        request->response = std::move(_free_buffers.back());
+        _free_buffers.pop_back();
+    }
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, &request->response);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_PRIVATE, request);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    const CURLMcode status_ = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status_ == CURLM_OK);
+}
+
+std::size_t CURL_AsyncScheduler::poll_completions(CURL_Completion* completions, std::size_t capacity)
+{
+    assert(completions || (capacity == 0));
+    const std::size_t available = _completed_size - _completed_head;
+    const std::size_t count = std::min(available, capacity);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        CURL_Completion& from = _completed[_completed_head + i];
+        CURL_Completion& to = completions[i];
+        to.user_data = from.user_data;
+        to.result = from.result;
+        to.response_code = from.response_code;
+        to.response.swap(from.response);
+    }
+    _completed_head += count;
+    if (_completed_head == _completed_size)
+    {   // drained: rewind, keeping records and their buffers
+        _completed_head = 0;
+        _completed_size = 0;
+    }
+    return count;
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout)
+{
+    const CURLMcode status = curl_multi_poll(CURL_scheduler(curl_async)._multi_curl
+        , nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    assert(status == CURLM_OK);
+}
+
+void CURL_async_submit(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data)
+{
+    CURL_scheduler(curl_async).submit(url, user_data);
+}
+
+std::size_t CURL_async_poll_completions(CURL_Async curl_async
+    , CURL_Completion* completions
+    , std::size_t capacity)
+{
+    return CURL_scheduler(curl_async).poll_completions(completions, capacity);
+}
+
+int main()
+{
+    struct State
+    {
+        int id = 0;
+        // follow-up requests to chain after this one completes
+        int remaining = 0;
+    };
+    CURL_Async curl_async = CURL_async_create();
+
+    std::vector<State> states(32);
+    for (std::size_t i = 0; i < states.size(); ++i)
+    {
+        states[i].id = static_cast<int>(i);
+        states[i].remaining = 3;
+        CURL_async_submit(curl_async, "localhost:5001/file1.txt", &states[i]);
+    }
+
+    CURL_Completion completions[8];
+    std::size_t in_flight = states.size();
+    std::size_t done = 0;
+    std::size_t batches = 0;
+    std::string last_response;
+    while (in_flight > 0)
+    {
+        CURL_async_wait(curl_async, std::chrono::milliseconds{100});
+        CURL_async_tick(curl_async);
+        // drain in bulk; outside of tick(), so submitting from here is safe
+        while (const std::size_t count = CURL_async_poll_completions(curl_async
+            , completions, std::size(completions)))
+        {
+            ++batches;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                CURL_Completion& completion = completions[i];
+                assert(completion.result == CURLE_OK);
+                assert(completion.response_code == 200L);
+                State& state = *static_cast<State*>(completion.user_data);
+                last_response = completion.response;
+                ++done;
+                --in_flight;
+                if (state.remaining-- > 0)
+                {
+                    CURL_async_submit(curl_async, "localhost:5001/file1.txt", &state);
+                    ++in_flight;
+                }
+            }
+        }
+    }
+    CURL_async_destroy(curl_async);
+
+    std::println("completed: {} in {} batches, last response: '{}'", done, batches, last_response);
+}
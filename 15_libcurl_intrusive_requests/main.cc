@@ -0,0 +1,454 @@
+#include <print>
+#include <string>
+#include <vector>
+#include <coroutine>
+#include <utility>
+#include <atomic>
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+
+// Caller-owned request (OVERLAPPED-style): embeds everything the scheduler
+// needs, so submission allocates nothing on our side. Must stay alive and
+// in place until on_complete is called; can be submitted again from there
+struct CURL_AsyncRequest
+{
+    CURL_AsyncRequest() = default;
+    // no copy, no move: scheduler links to it
+    CURL_AsyncRequest(const CURL_AsyncRequest&) = delete;
+    ~CURL_AsyncRequest() noexcept;
+
+    // filled by the caller
+    std::string url;
+    void* user_data = nullptr;
+    void (*on_complete)(CURL_AsyncRequest& request) = nullptr;
+
+    // filled by the scheduler; response keeps its capacity between submits
+    std::string response;
+    CURLcode result = CURLE_OK;
+    long response_code = -1;
+
+    // scheduler-owned: easy handle is reused by the next submit
+    CURL* _curl_easy = nullptr;
+    // in-flight list (doubly-linked), then completed list (via _next)
+    CURL_AsyncRequest* _prev = nullptr;
+    CURL_AsyncRequest* _next = nullptr;
+    bool _in_flight = false;
+};
+
+void CURL_async_submit(CURL_Async curl_async, CURL_AsyncRequest& request);
+
+// our allocations only: libcurl still does its own malloc() per transfer
+static std::atomic<std::uint64_t> g_App_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    g_App_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+CURL_AsyncRequest::~CURL_AsyncRequest() noexcept
+{
+    assert(!_in_flight);
+    if (_curl_easy)
+    {
+        curl_easy_cleanup(_curl_easy);
+    }
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    void tick();
+    void submit(CURL_AsyncRequest& request);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    // intrusive list of in-flight requests; nodes are caller's memory
+    CURL_AsyncRequest* _in_flight = nullptr;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    // requests are not ours to complete: just detach them
+    while (CURL_AsyncRequest* request = _in_flight)
+    {
+        const CURLMcode status = curl_multi_remove_handle(_multi_curl, request->_curl_easy);
+        assert(status == CURLM_OK);
+        _in_flight = request->_next;
+        request->_prev = nullptr;
+        request->_next = nullptr;
+        request->_in_flight = false;
+    }
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    // 1. bookkeeping only: move finished requests to completed list
+    CURL_AsyncRequest* completed = nullptr;
+    CURL_AsyncRequest** completed_tail = &completed;
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        const CURLcode result = m->data.result;
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        char* private_data = nullptr;
+        CURLcode status_ = curl_easy_getinfo(curl_easy, CURLINFO_PRIVATE, &private_data);
+        assert(status_ == CURLE_OK);
+        CURL_AsyncRequest& request = *reinterpret_cast<CURL_AsyncRequest*>(private_data);
+        assert(request._curl_easy == curl_easy);
+        assert(request._in_flight);
+        status_ = curl_easy_getinfo(curl_easy, CURLINFO_RESPONSE_CODE, &request.response_code);
+        assert(status_ == CURLE_OK);
+        request.result = result;
+
+        // unlink from in-flight
+        if (request._prev)
+        {
+            request._prev->_next = request._next;
+        }
+        else
+        {
+            _in_flight = request._next;
+        }
+        if (request._next)
+        {
+            request._next->_prev = request._prev;
+        }
+        request._prev = nullptr;
+        request._next = nullptr;
+        request._in_flight = false;
+        *completed_tail = &request;
+        completed_tail = &request._next;
+    }
+
+    // 2. only now run user code: it may submit (even the same request) again
+    while (CURL_AsyncRequest* request = completed)
+    {
+        completed = std::exchange(request->_next, nullptr);
+        assert(request->on_complete);
+        request->on_complete(*request);
+    }
+}
+
+void CURL_AsyncScheduler::submit(CURL_AsyncRequest& request)
+{
+    assert(!request._in_flight);
+    assert(request.on_complete);
+
+    // 1. setup (or reuse) curl easy handle
+    if (request._curl_easy)
+    {
+        curl_easy_reset(request._curl_easy);
+    }
+    else
+    {
+        request._curl_easy = curl_easy_init();
+        assert(request._curl_easy);
+    }
+    CURL* curl_easy = request._curl_easy;
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, request.url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_PRIVATE, &request);
+    assert(status == CURLE_OK);
+
+    // 2. write response data directly into the request
+    request.response.clear();
+    request.result = CURLE_OK;
+    request.response_code = -1;
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, &request.response);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    const CURLMcode status_ = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status_ == CURLM_OK);
+    request._prev = nullptr;
+    request._next = _in_flight;
+    if (_in_flight)
+    {
+        _in_flight->_prev = &request;
+    }
+    _in_flight = &request;
+    request._in_flight = true;
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_submit(CURL_Async curl_async, CURL_AsyncRequest& request)
+{
+    CURL_scheduler(curl_async).submit(request);
+}
+
+struct Co_Task
+{
+    struct promise_type;
+    using co_handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type
+    {
+        Co_Task get_return_object()
+        {
+            return Co_Task{co_handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+            // yeah, we return void. Nothing to do
+        }
+
+        void unhandled_exception()
+        {
+            // crash, no exceptions handling
+            assert(false);
+        }
+    };
+
+    Co_Task(co_handle coro)
+        : _coro{coro} {}
+    Co_Task(Co_Task&& rhs) noexcept
+        : _coro{std::exchange(rhs._coro, {})} { }
+    Co_Task(const Co_Task&) = delete;
+    ~Co_Task() noexcept
+    {
+        if (_coro)
+        {
+            _coro.destroy();
+        }
+    }
+
+    void resume()
+    {
+        assert(_coro);
+        assert(!_coro.done());
+        _coro.resume();
+    }
+
+    bool is_in_progress() const
+    {
+        assert(_coro);
+        return !_coro.done();
+    }
+
+    co_handle _coro;
+};
+
+// the awaiter lives in the coroutine frame, so does the embedded request:
+// no allocations per co_await besides the frame itself
+struct Co_CurlAsync
+{
+    Co_CurlAsync(CURL_Async curl_async, const std::string& url)
+        : _curl_async{curl_async}
+    {
+        _request.url = url;
+    }
+
+    CURL_Async _curl_async{};
+    std::coroutine_handle<> _coro;
+    CURL_AsyncRequest _request;
+
+    bool await_ready()
+    { // 1. CURL_async_submit() is not yet started, force coroutine suspend:
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    { // 2. remember coroutine handle, start request, resume on finish:
+        _coro = coro;
+        _request.user_data = this;
+        _request.on_complete = [](CURL_AsyncRequest& request)
+        {
+            Co_CurlAsync& self = *static_cast<Co_CurlAsync*>(request.user_data);
+            self._coro.resume();
+        };
+        CURL_async_submit(_curl_async, _request);
+    }
+
+    std::string await_resume()
+    { // 3. after resume, return response:
+        assert(_request.response_code == 200L);
+        return std::move(_request.response);
+    }
+};
+
+// guaranteed copy elision: the request is constructed in place
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url)
+{
+    return Co_CurlAsync{curl_async, url};
+}
+
+static Co_Task coro_main(CURL_Async curl_async)
+{
+    const std::string response = co_await CURL_await_get(
+        curl_async, "localhost:5001/file1.txt");
+
+    std::println("coro_main response: '{}'", response);
+    co_return;
+}
+
+// long-running service: fixed set of requests, resubmitted on completion
+struct App_Service
+{
+    CURL_Async curl_async = nullptr;
+    std::size_t to_submit = 0;
+    std::size_t completed = 0;
+    std::size_t bytes = 0;
+};
+
+static void App_OnComplete(CURL_AsyncRequest& request)
+{
+    App_Service& service = *static_cast<App_Service*>(request.user_data);
+    assert(request.result == CURLE_OK);
+    assert(request.response_code == 200L);
+    service.bytes += request.response.size();
+    ++service.completed;
+    if (service.to_submit > 0)
+    {
+        --service.to_submit;
+        CURL_async_submit(service.curl_async, request);
+    }
+}
+
+static void App_Run(App_Service& service, std::vector<CURL_AsyncRequest>& requests, std::size_t total)
+{
+    service.to_submit = total - requests.size();
+    service.completed = 0;
+    for (CURL_AsyncRequest& request : requests)
+    {
+        CURL_async_submit(service.curl_async, request);
+    }
+    while (service.completed < total)
+    {
+        CURL_async_tick(service.curl_async);
+    }
+}
+
+int main()
+{
+    CURL_Async curl_async = CURL_async_create();
+
+    // 1. coroutine with the request embedded into the awaiter
+    Co_Task task = coro_main(curl_async);
+    task.resume();
+    while (task.is_in_progress())
+    {
+        CURL_async_tick(curl_async);
+    }
+
+    // 2. recycled requests; 1st run warms up easy handles and buffers
+    App_Service service;
+    service.curl_async = curl_async;
+    std::vector<CURL_AsyncRequest> requests(32);
+    for (CURL_AsyncRequest& request : requests)
+    {
+        request.url = "localhost:5001/file1.txt";
+        request.user_data = &service;
+        request.on_complete = &App_OnComplete;
+    }
+    App_Run(service, requests, 256);
+    const std::uint64_t allocations = g_App_allocations.load(std::memory_order_relaxed);
+    App_Run(service, requests, 256);
+    const std::uint64_t steady = g_App_allocations.load(std::memory_order_relaxed) - allocations;
+
+    requests.clear();
+    CURL_async_destroy(curl_async);
+
+    std::println("requests: 256 x 2 over {} objects, bytes: {}", 32, service.bytes);
+    std::println("allocations in steady state run: {}", steady);
+}
@@ -0,0 +1,589 @@
+#include <print>
+#include <string>
+#include <functional>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string_view>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(__x86_64__)
+#  include <ucontext.h>
+#endif
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// M:N fibers runtime: M fibers over N worker threads, each worker owns
+// its libcurl multi handle and steals ready fibers from others when idle
+struct Fib_Runtime;
+void Fib_yield();
+// looks blocking like CURL_get(), but parks the calling fiber until done;
+// must be called from inside a fiber
+std::string CURL_fiber_get(const std::string& url);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+// mmap'd stack with PROT_NONE guard page below: overflow faults
+// instead of silently corrupting a neighbour
+struct Fib_Stack
+{
+    static constexpr std::size_t kSize = 64 * 1024;
+
+    static Fib_Stack allocate();
+    void free();
+
+    void* top() const
+    {
+        return static_cast<char*>(base) + size;
+    }
+
+    void* base = nullptr; // including guard page
+    std::size_t size = 0;
+};
+
+Fib_Stack Fib_Stack::allocate()
+{
+    const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    Fib_Stack stack;
+    stack.size = kSize + page;
+    stack.base = ::mmap(nullptr, stack.size, PROT_READ | PROT_WRITE
+        , MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    assert(stack.base != MAP_FAILED);
+    const int status = ::mprotect(stack.base, page, PROT_NONE);
+    assert(status == 0);
+    return stack;
+}
+
+void Fib_Stack::free()
+{
+    const int status = ::munmap(base, size);
+    assert(status == 0);
+    base = nullptr;
+}
+
+// Context switch. x86-64 System V: save callee-saved registers, MXCSR and
+// x87 control word on the current stack, swap stack pointers, restore
+#if defined(__x86_64__)
+struct Fib_Context
+{
+    void* sp = nullptr;
+};
+
+extern "C" void Fib_switch_context(void** from_sp, void* to_sp);
+
+asm(R"(
+    .text
+    .globl Fib_switch_context
+    .type Fib_switch_context, @function
+Fib_switch_context:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size Fib_switch_context, .-Fib_switch_context
+    .section .note.GNU-stack,"",@progbits
+    .text
+)");
+
+static void Fib_context_init(Fib_Context& context, const Fib_Stack& stack, void (*entry)())
+{
+    // frame as if Fib_switch_context() was called from `entry`:
+    // 8 bytes MXCSR/x87 CW, 6 registers, return address; 16-byte aligned so
+    // that `entry` starts with rsp % 16 == 8, like after a call
+    std::uintptr_t top = reinterpret_cast<std::uintptr_t>(stack.top()) & ~std::uintptr_t{15};
+    std::uint64_t* sp = reinterpret_cast<std::uint64_t*>(top);
+    *--sp = 0; // padding, entry never returns
+    *--sp = reinterpret_cast<std::uint64_t>(entry);
+    for (int i = 0; i < 6; ++i)
+    {
+        *--sp = 0;
+    }
+    --sp;
+    const std::uint32_t mxcsr = 0x1F80;
+    const std::uint16_t x87_cw = 0x037F;
+    std::memcpy(sp, &mxcsr, sizeof(mxcsr));
+    std::memcpy(reinterpret_cast<char*>(sp) + 4, &x87_cw, sizeof(x87_cw));
+    context.sp = sp;
+}
+
+static void Fib_context_switch(Fib_Context& from, Fib_Context& to)
+{
+    Fib_switch_context(&from.sp, to.sp);
+}
+#else
+// portable, but slower (saves signal mask with a syscall)
+struct Fib_Context
+{
+    ucontext_t uc{};
+};
+
+static void Fib_context_init(Fib_Context& context, const Fib_Stack& stack, void (*entry)())
+{
+    const int status = getcontext(&context.uc);
+    assert(status == 0);
+    context.uc.uc_stack.ss_sp = stack.base;
+    context.uc.uc_stack.ss_size = stack.size;
+    context.uc.uc_link = nullptr;
+    makecontext(&context.uc, entry, 0);
+}
+
+static void Fib_context_switch(Fib_Context& from, Fib_Context& to)
+{
+    const int status = swapcontext(&from.uc, &to.uc);
+    assert(status == 0);
+}
+#endif
+
+struct Fib_Fiber
+{
+    enum class State { Ready, Running, Yielded, Parked, Done };
+
+    Fib_Context _context;
+    Fib_Stack _stack;
+    std::function<void ()> _fn;
+    State _state = State::Ready;
+};
+
+struct Fib_Worker
+{
+    // owner pops newest (warm stack), thieves take oldest
+    Fib_Fiber* pop();
+    Fib_Fiber* steal_from();
+    void push(Fib_Fiber* fiber);
+    void loop();
+    void run(Fib_Fiber* fiber);
+    void tick();
+    Fib_Stack acquire_stack();
+    void release_stack(Fib_Stack stack);
+
+    // stacks kept per worker; more than that go back to the OS
+    static constexpr std::size_t kMaxPooledStacks = 256;
+    // fibers to run before servicing libcurl again
+    static constexpr std::size_t kRunBatch = 64;
+
+    Fib_Runtime* _runtime = nullptr;
+    std::size_t _index = 0;
+    Fib_Context _context;
+    Fib_Fiber* _current = nullptr;
+    std::mutex _ready_mutex;
+    std::deque<Fib_Fiber*> _ready;
+    CURLM* _multi_curl = nullptr;
+    std::vector<Fib_Stack> _stacks;
+    // stats, owned by the worker thread: read only after Fib_Runtime::stop()
+    std::size_t _steals = 0;
+    std::size_t _stacks_mapped = 0;
+    std::size_t _transfers = 0;
+    std::thread _thread;
+};
+
+struct Fib_Runtime
+{
+    explicit Fib_Runtime(std::size_t threads);
+    ~Fib_Runtime();
+    // no copy, no move
+    Fib_Runtime(const Fib_Runtime&) = delete;
+
+    // from any thread, including fibers
+    void spawn(std::function<void ()> fn);
+    // waits for all spawned fibers
+    void join();
+    // join(), then stops and joins worker threads; idempotent
+    void stop();
+
+    std::vector<std::unique_ptr<Fib_Worker>> _workers;
+    std::atomic<std::size_t> _live{0};
+    std::atomic<std::size_t> _next_worker{0};
+    std::atomic<bool> _stop{false};
+};
+
+static thread_local Fib_Worker* g_Fib_worker = nullptr;
+
+// thread_local address must be re-read after every switch: a fiber
+// may continue on another thread; noinline so it isn't cached
+[[gnu::noinline]] static Fib_Worker* Fib_this_worker()
+{
+    Fib_Worker* worker = g_Fib_worker;
+    asm volatile("" ::: "memory");
+    return worker;
+}
+
+[[noreturn]] static void Fib_Entry()
+{
+    Fib_Fiber* fiber = Fib_this_worker()->_current;
+    assert(fiber);
+    fiber->_fn();
+    fiber->_fn = nullptr;
+    fiber->_state = Fib_Fiber::State::Done;
+    Fib_context_switch(fiber->_context, Fib_this_worker()->_context);
+    // never resumed
+    std::abort();
+}
+
+void Fib_Worker::push(Fib_Fiber* fiber)
+{
+    std::lock_guard lock{_ready_mutex};
+    _ready.push_back(fiber);
+}
+
+Fib_Fiber* Fib_Worker::pop()
+{
+    std::lock_guard lock{_ready_mutex};
+    if (_ready.empty())
+    {
+        return nullptr;
+    }
+    Fib_Fiber* fiber = _ready.back();
+    _ready.pop_back();
+    return fiber;
+}
+
+Fib_Fiber* Fib_Worker::steal_from()
+{
+    std::unique_lock lock{_ready_mutex, std::try_to_lock};
+    if (!lock || _ready.empty())
+    {
+        return nullptr;
+    }
+    Fib_Fiber* fiber = _ready.front();
+    _ready.pop_front();
+    return fiber;
+}
+
+Fib_Stack Fib_Worker::acquire_stack()
+{
+    if (_stacks.empty())
+    {
+        ++_stacks_mapped;
+        return Fib_Stack::allocate();
+    }
+    Fib_Stack stack = _stacks.back();
+    _stacks.pop_back();
+    return stack;
+}
+
+void Fib_Worker::release_stack(Fib_Stack stack)
+{
+    if (_stacks.size() < kMaxPooledStacks)
+    {
+        _stacks.push_back(stack);
+    }
+    else
+    {
+        stack.free();
+    }
+}
+
+void Fib_Worker::run(Fib_Fiber* fiber)
+{
+    if (!fiber->_stack.base)
+    {   // first run: stack comes from the worker that starts it
+        fiber->_stack = acquire_stack();
+        Fib_context_init(fiber->_context, fiber->_stack, &Fib_Entry);
+    }
+    _current = fiber;
+    fiber->_state = Fib_Fiber::State::Running;
+    Fib_context_switch(_context, fiber->_context);
+    _current = nullptr;
+    // fiber is fully switched out: safe to hand it to anyone now
+    switch (fiber->_state)
+    {
+    case Fib_Fiber::State::Yielded:
+        fiber->_state = Fib_Fiber::State::Ready;
+        push(fiber);
+        break;
+    case Fib_Fiber::State::Parked:
+        // tick() pushes it back when its transfer is done
+        break;
+    case Fib_Fiber::State::Done:
+        release_stack(fiber->_stack);
+        delete fiber;
+        if (_runtime->_live.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            _runtime->_live.notify_all();
+        }
+        break;
+    default:
+        assert(false);
+    }
+}
+
+void Fib_Worker::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        char* private_data = nullptr;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy, CURLINFO_PRIVATE, &private_data);
+        assert(status_ == CURLE_OK);
+        Fib_Fiber* fiber = reinterpret_cast<Fib_Fiber*>(private_data);
+        assert(fiber && (fiber->_state == Fib_Fiber::State::Parked));
+        fiber->_state = Fib_Fiber::State::Ready;
+        ++_transfers;
+        push(fiber);
+    }
+}
+
+void Fib_Worker::loop()
+{
+    g_Fib_worker = this;
+    const std::size_t workers = _runtime->_workers.size();
+    while (!_runtime->_stop.load(std::memory_order_acquire))
+    {
+        std::size_t ran = 0;
+        for (; ran < kRunBatch; ++ran)
+        {
+            Fib_Fiber* fiber = pop();
+            for (std::size_t i = 1; !fiber && (i < workers); ++i)
+            {
+                fiber = _runtime->_workers[(_index + i) % workers]->steal_from();
+                if (fiber)
+                {
+                    ++_steals;
+                }
+            }
+            if (!fiber)
+            {
+                break;
+            }
+            run(fiber);
+        }
+        tick();
+        if (ran == 0)
+        {   // idle: sleep on own sockets; short, to notice work to steal
+            const CURLMcode status = curl_multi_poll(_multi_curl, nullptr, 0, 1, nullptr);
+            assert(status == CURLM_OK);
+        }
+    }
+    g_Fib_worker = nullptr;
+}
+
+Fib_Runtime::Fib_Runtime(std::size_t threads)
+{
+    assert(threads > 0);
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        std::unique_ptr<Fib_Worker> worker = std::make_unique<Fib_Worker>();
+        worker->_runtime = this;
+        worker->_index = i;
+        worker->_multi_curl = curl_multi_init();
+        assert(worker->_multi_curl);
+        _workers.push_back(std::move(worker));
+    }
+    // all workers exist before anyone tries to steal
+    for (std::unique_ptr<Fib_Worker>& worker : _workers)
+    {
+        worker->_thread = std::thread{&Fib_Worker::loop, worker.get()};
+    }
+}
+
+Fib_Runtime::~Fib_Runtime()
+{
+    stop();
+    for (std::unique_ptr<Fib_Worker>& worker : _workers)
+    {
+        for (Fib_Stack& stack : worker->_stacks)
+        {
+            stack.free();
+        }
+        const CURLMcode status = curl_multi_cleanup(worker->_multi_curl);
+        assert(status == CURLM_OK);
+    }
+    curl_global_cleanup();
+}
+
+void Fib_Runtime::spawn(std::function<void ()> fn)
+{
+    assert(fn);
+    Fib_Fiber* fiber = new Fib_Fiber{};
+    fiber->_fn = std::move(fn);
+    _live.fetch_add(1, std::memory_order_relaxed);
+    Fib_Worker* current = Fib_this_worker();
+    if (current && (current->_runtime == this))
+    {
+        current->push(fiber);
+        return;
+    }
+    Fib_Worker& worker = *_workers[_next_worker.fetch_add(1, std::memory_order_relaxed) % _workers.size()];
+    worker.push(fiber);
+    const CURLMcode status = curl_multi_wakeup(worker._multi_curl);
+    assert(status == CURLM_OK);
+}
+
+void Fib_Runtime::join()
+{
+    std::size_t live = _live.load(std::memory_order_acquire);
+    while (live != 0)
+    {
+        _live.wait(live, std::memory_order_acquire);
+        live = _live.load(std::memory_order_acquire);
+    }
+}
+
+void Fib_Runtime::stop()
+{
+    join();
+    _stop.store(true, std::memory_order_release);
+    for (std::unique_ptr<Fib_Worker>& worker : _workers)
+    {
+        const CURLMcode status = curl_multi_wakeup(worker->_multi_curl);
+        assert(status == CURLM_OK);
+    }
+    for (std::unique_ptr<Fib_Worker>& worker : _workers)
+    {
+        if (worker->_thread.joinable())
+        {
+            worker->_thread.join();
+        }
+    }
+}
+
+void Fib_yield()
+{
+    Fib_Worker* worker = Fib_this_worker();
+    assert(worker && worker->_current);
+    Fib_Fiber* fiber = worker->_current;
+    fiber->_state = Fib_Fiber::State::Yielded;
+    Fib_context_switch(fiber->_context, worker->_context);
+}
+
+std::string CURL_fiber_get(const std::string& url)
+{
+    Fib_Worker* worker = Fib_this_worker();
+    assert(worker && worker->_current);
+    Fib_Fiber* fiber = worker->_current;
+
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_PRIVATE, fiber);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to the fiber's stack; it stays put while parked
+    std::string response;
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, &response);
+    assert(status == CURLE_OK);
+
+    // 3. associate with this worker's multi handle, park until done
+    const CURLMcode status_ = curl_multi_add_handle(worker->_multi_curl, curl_easy);
+    assert(status_ == CURLM_OK);
+    fiber->_state = Fib_Fiber::State::Parked;
+    Fib_context_switch(fiber->_context, worker->_context);
+    // resumed, maybe on another worker: don't touch `worker` anymore
+
+    long response_code = -1;
+    status = curl_easy_getinfo(curl_easy, CURLINFO_RESPONSE_CODE, &response_code);
+    assert(status == CURLE_OK);
+    assert(response_code == 200L);
+    curl_easy_cleanup(curl_easy);
+    return response;
+}
+
+// "legacy" blocking code: only CURL_get() was renamed to CURL_fiber_get()
+static std::size_t App_LegacyFetch(const std::string& url)
+{
+    const std::string r1 = CURL_fiber_get(url);
+    const std::string r2 = CURL_fiber_get(url);
+    return (r1.size() + r2.size());
+}
+
+// usage: [fibers] [threads]
+int main(int argc, char* argv[])
+{
+    std::size_t fibers = 1000;
+    if (argc > 1)
+    {
+        const std::string_view arg = argv[1];
+        const std::from_chars_result r = std::from_chars(arg.data(), arg.data() + arg.size(), fibers);
+        assert((r.ec == std::errc{}) && (fibers > 0));
+    }
+    std::size_t threads = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+    if (argc > 2)
+    {
+        const std::string_view arg = argv[2];
+        const std::from_chars_result r = std::from_chars(arg.data(), arg.data() + arg.size(), threads);
+        assert((r.ec == std::errc{}) && (threads > 0));
+    }
+
+    std::atomic<std::size_t> bytes{0};
+    std::size_t steals = 0;
+    std::size_t stacks = 0;
+    std::size_t transfers = 0;
+    {
+        Fib_Runtime runtime{threads};
+        for (std::size_t i = 0; i < fibers; ++i)
+        {
+            runtime.spawn([&bytes]()
+            {
+                bytes.fetch_add(App_LegacyFetch("localhost:5001/file1.txt"), std::memory_order_relaxed);
+                Fib_yield();
+            });
+        }
+        // workers keep looping after join(), stats are stable only once stopped
+        runtime.stop();
+        for (const std::unique_ptr<Fib_Worker>& worker : runtime._workers)
+        {
+            steals += worker->_steals;
+            stacks += worker->_stacks_mapped;
+            transfers += worker->_transfers;
+        }
+    }
+
+    std::println("fibers: {}, threads: {}, transfers: {}, bytes: {}"
+        , fibers, threads, transfers, bytes.load());
+    std::println("steals: {}, stacks mapped: {}", steals, stacks);
+}
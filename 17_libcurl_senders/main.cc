@@ -0,0 +1,683 @@
+#include <print>
+#include <string>
+#include <optional>
+#include <expected>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <chrono>
+#include <atomic>
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+// sleeps in curl_multi_poll() until socket activity or timeout
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout);
+
+// Intrusive transfer, embedded into whoever starts it (operation states
+// below); the scheduler never allocates per request
+struct CURL_Transfer
+{
+    CURL_Transfer() = default;
+    // no copy, no move: scheduler links to it
+    CURL_Transfer(const CURL_Transfer&) = delete;
+    ~CURL_Transfer() noexcept;
+
+    std::string response;
+    CURLcode result = CURLE_OK;
+    long response_code = -1;
+    void* owner = nullptr;
+    void (*on_complete)(CURL_Transfer& transfer) = nullptr;
+
+    CURL* _curl_easy = nullptr;
+    // completed list, see tick()
+    CURL_Transfer* _next = nullptr;
+};
+
+// `url` is copied by libcurl, needs to live only for the call
+void CURL_async_start(CURL_Async curl_async, CURL_Transfer& transfer, const char* url);
+
+// our allocations only: libcurl still does its own malloc() per transfer
+static std::atomic<std::uint64_t> g_App_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    g_App_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+CURL_Transfer::~CURL_Transfer() noexcept
+{
+    if (_curl_easy)
+    {
+        curl_easy_cleanup(_curl_easy);
+    }
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    void tick();
+    void start(CURL_Transfer& transfer, const char* url);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    // 1. bookkeeping only
+    CURL_Transfer* completed = nullptr;
+    CURL_Transfer** completed_tail = &completed;
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        const CURLcode result = m->data.result;
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        char* private_data = nullptr;
+        CURLcode status_ = curl_easy_getinfo(curl_easy, CURLINFO_PRIVATE, &private_data);
+        assert(status_ == CURLE_OK);
+        CURL_Transfer& transfer = *reinterpret_cast<CURL_Transfer*>(private_data);
+        assert(transfer._curl_easy == curl_easy);
+        status_ = curl_easy_getinfo(curl_easy, CURLINFO_RESPONSE_CODE, &transfer.response_code);
+        assert(status_ == CURLE_OK);
+        transfer.result = result;
+        *completed_tail = &transfer;
+        completed_tail = &transfer._next;
+    }
+    // 2. completions may start new transfers (let_value)
+    while (CURL_Transfer* transfer = completed)
+    {
+        completed = std::exchange(transfer->_next, nullptr);
+        assert(transfer->on_complete);
+        transfer->on_complete(*transfer);
+    }
+}
+
+void CURL_AsyncScheduler::start(CURL_Transfer& transfer, const char* url)
+{
+    assert(url);
+    assert(transfer.on_complete);
+    // 1. setup (or reuse) curl easy handle
+    if (transfer._curl_easy)
+    {
+        curl_easy_reset(transfer._curl_easy);
+    }
+    else
+    {
+        transfer._curl_easy = curl_easy_init();
+        assert(transfer._curl_easy);
+    }
+    CURL* curl_easy = transfer._curl_easy;
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_PRIVATE, &transfer);
+    assert(status == CURLE_OK);
+
+    // 2. write response data directly into the transfer
+    transfer.response.clear();
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, &transfer.response);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    const CURLMcode status_ = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status_ == CURLM_OK);
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout)
+{
+    const CURLMcode status = curl_multi_poll(CURL_scheduler(curl_async)._multi_curl
+        , nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    assert(status == CURLM_OK);
+}
+
+void CURL_async_start(CURL_Async curl_async, CURL_Transfer& transfer, const char* url)
+{
+    CURL_scheduler(curl_async).start(transfer, url);
+}
+
+// Senders, P2300-like but much reduced:
+//  - sender: `value_type` (exactly one value) + `connect(receiver) &&`;
+//  - receiver: `set_value(value_type)` and `set_error(CURLcode)`;
+//  - operation state: not movable, `start()` exactly once.
+// Operation states nest by value, so the whole pipeline is one object
+// of a size known at compile time; connect()/start() never allocate
+template<typename S, typename R>
+using Snd_Operation = decltype(std::declval<S>().connect(std::declval<R>()));
+
+// construct non-movable operation state in place from connect()'s prvalue
+template<typename F>
+struct Snd_Emplace
+{
+    F f;
+    operator std::invoke_result_t<F&>()
+    {
+        return f();
+    }
+};
+
+template<typename R>
+struct Snd_GetOperation
+{
+    Snd_GetOperation(CURL_Async curl_async, const char* url, R receiver)
+        : _curl_async{curl_async}
+        , _url{url}
+        , _receiver{std::move(receiver)} {}
+    // no copy, no move: _transfer is linked by the scheduler
+    Snd_GetOperation(const Snd_GetOperation&) = delete;
+
+    void start()
+    {
+        assert(!_started);
+        _started = true;
+        _transfer.owner = this;
+        _transfer.on_complete = [](CURL_Transfer& transfer)
+        {
+            Snd_GetOperation& self = *static_cast<Snd_GetOperation*>(transfer.owner);
+            if (transfer.result != CURLE_OK)
+            {
+                self._receiver.set_error(transfer.result);
+            }
+            else if (transfer.response_code != 200L)
+            {
+                self._receiver.set_error(CURLE_HTTP_RETURNED_ERROR);
+            }
+            else
+            {
+                self._receiver.set_value(std::move(transfer.response));
+            }
+        };
+        CURL_async_start(_curl_async, _transfer, _url);
+    }
+
+    CURL_Async _curl_async{};
+    const char* _url = nullptr;
+    R _receiver;
+    CURL_Transfer _transfer;
+    bool _started = false;
+};
+
+struct Snd_GetSender
+{
+    using value_type = std::string;
+
+    template<typename R>
+    Snd_GetOperation<R> connect(R receiver) &&
+    {
+        return Snd_GetOperation<R>{_curl_async, _url, std::move(receiver)};
+    }
+
+    CURL_Async _curl_async{};
+    // not owned, see CURL_async_start()
+    const char* _url = nullptr;
+};
+
+Snd_GetSender curl_get_sender(CURL_Async curl_async, const char* url)
+{
+    return Snd_GetSender{curl_async, url};
+}
+
+// then(s, f): value `v` becomes `f(v)`
+template<typename R, typename F>
+struct Snd_ThenReceiver
+{
+    template<typename V>
+    void set_value(V&& value)
+    {
+        _receiver.set_value(_f(std::forward<V>(value)));
+    }
+
+    void set_error(CURLcode error)
+    {
+        _receiver.set_error(error);
+    }
+
+    R _receiver;
+    F _f;
+};
+
+template<typename S, typename F>
+struct Snd_ThenSender
+{
+    using value_type = std::invoke_result_t<F&, typename S::value_type>;
+    static_assert(!std::is_void_v<value_type>, "then() needs a value");
+
+    template<typename R>
+    Snd_Operation<S, Snd_ThenReceiver<R, F>> connect(R receiver) &&
+    {
+        return std::move(_sender).connect(Snd_ThenReceiver<R, F>{std::move(receiver), std::move(_f)});
+    }
+
+    S _sender;
+    F _f;
+};
+
+template<typename S, typename F>
+Snd_ThenSender<S, F> then(S sender, F f)
+{
+    return Snd_ThenSender<S, F>{std::move(sender), std::move(f)};
+}
+
+// let_value(s, f): `f(v)` returns next sender; `v` is kept alive until it ends
+template<typename S, typename F, typename R>
+struct Snd_LetValueOperation
+{
+    using Value = typename S::value_type;
+    using Next = std::invoke_result_t<F&, Value&>;
+
+    struct FirstReceiver
+    {
+        void set_value(Value value)
+        {
+            _op->start_next(std::move(value));
+        }
+
+        void set_error(CURLcode error)
+        {
+            _op->_receiver.set_error(error);
+        }
+
+        Snd_LetValueOperation* _op;
+    };
+
+    struct NextReceiver
+    {
+        void set_value(typename Next::value_type value)
+        {
+            _op->_receiver.set_value(std::move(value));
+        }
+
+        void set_error(CURLcode error)
+        {
+            _op->_receiver.set_error(error);
+        }
+
+        Snd_LetValueOperation* _op;
+    };
+
+    Snd_LetValueOperation(S sender, F f, R receiver)
+        : _first{std::move(sender).connect(FirstReceiver{this})}
+        , _f{std::move(f)}
+        , _receiver{std::move(receiver)} {}
+    // no copy, no move
+    Snd_LetValueOperation(const Snd_LetValueOperation&) = delete;
+
+    void start()
+    {
+        _first.start();
+    }
+
+    void start_next(Value value)
+    {
+        _value.emplace(std::move(value));
+        _next.emplace(Snd_Emplace{[this]()
+        {
+            return _f(*_value).connect(NextReceiver{this});
+        }});
+        _next->start();
+    }
+
+    Snd_Operation<S, FirstReceiver> _first;
+    F _f;
+    R _receiver;
+    std::optional<Value> _value;
+    // storage reserved inline, constructed when the first completes
+    std::optional<Snd_Operation<Next, NextReceiver>> _next;
+};
+
+template<typename S, typename F>
+struct Snd_LetValueSender
+{
+    using value_type = typename std::invoke_result_t<F&, typename S::value_type&>::value_type;
+
+    template<typename R>
+    Snd_LetValueOperation<S, F, R> connect(R receiver) &&
+    {
+        return Snd_LetValueOperation<S, F, R>{std::move(_sender), std::move(_f), std::move(receiver)};
+    }
+
+    S _sender;
+    F _f;
+};
+
+template<typename S, typename F>
+Snd_LetValueSender<S, F> let_value(S sender, F f)
+{
+    return Snd_LetValueSender<S, F>{std::move(sender), std::move(f)};
+}
+
+// when_all(s...): all start together, value is std::tuple of all values;
+// on error, the first one is reported once all finished
+template<typename Op, std::size_t I>
+struct Snd_WhenAllReceiver
+{
+    template<typename V>
+    void set_value(V&& value)
+    {
+        std::get<I>(_op->_values).emplace(std::forward<V>(value));
+        _op->arrive();
+    }
+
+    void set_error(CURLcode error)
+    {
+        if (_op->_error == CURLE_OK)
+        {
+            _op->_error = error;
+        }
+        _op->arrive();
+    }
+
+    Op* _op;
+};
+
+// one base per child: each child operation is constructed in place
+template<typename Op, std::size_t I, typename S>
+struct Snd_WhenAllChild
+{
+    Snd_WhenAllChild(S&& sender, Op* op)
+        : _child{std::move(sender).connect(Snd_WhenAllReceiver<Op, I>{op})} {}
+
+    Snd_Operation<S, Snd_WhenAllReceiver<Op, I>> _child;
+};
+
+template<typename R, typename Indices, typename... S>
+struct Snd_WhenAllOperation;
+
+template<typename R, std::size_t... I, typename... S>
+struct Snd_WhenAllOperation<R, std::index_sequence<I...>, S...>
+    : Snd_WhenAllChild<Snd_WhenAllOperation<R, std::index_sequence<I...>, S...>, I, S>...
+{
+    Snd_WhenAllOperation(std::tuple<S...>&& senders, R receiver)
+        : Snd_WhenAllChild<Snd_WhenAllOperation, I, S>{std::move(std::get<I>(senders)), this}...
+        , _receiver{std::move(receiver)} {}
+    // no copy, no move
+    Snd_WhenAllOperation(const Snd_WhenAllOperation&) = delete;
+
+    void start()
+    {
+        (Snd_WhenAllChild<Snd_WhenAllOperation, I, S>::_child.start(), ...);
+    }
+
+    void arrive()
+    {
+        if (--_remaining > 0)
+        {
+            return;
+        }
+        if (_error != CURLE_OK)
+        {
+            _receiver.set_error(_error);
+            return;
+        }
+        _receiver.set_value(std::tuple<typename S::value_type...>{
+            std::move(*std::get<I>(_values))...});
+    }
+
+    R _receiver;
+    std::tuple<std::optional<typename S::value_type>...> _values;
+    std::size_t _remaining = sizeof...(S);
+    CURLcode _error = CURLE_OK;
+};
+
+template<typename... S>
+struct Snd_WhenAllSender
+{
+    using value_type = std::tuple<typename S::value_type...>;
+
+    template<typename R>
+    Snd_WhenAllOperation<R, std::index_sequence_for<S...>, S...> connect(R receiver) &&
+    {
+        return Snd_WhenAllOperation<R, std::index_sequence_for<S...>, S...>{
+            std::move(_senders), std::move(receiver)};
+    }
+
+    std::tuple<S...> _senders;
+};
+
+template<typename... S>
+Snd_WhenAllSender<S...> when_all(S... senders)
+{
+    static_assert(sizeof...(S) > 0);
+    return Snd_WhenAllSender<S...>{std::tuple<S...>{std::move(senders)...}};
+}
+
+// bulk(s, n, f): `f(i, v)` for i in [0, n), then `v` is passed on
+template<typename R, typename F>
+struct Snd_BulkReceiver
+{
+    template<typename V>
+    void set_value(V&& value)
+    {
+        for (std::size_t i = 0; i < _count; ++i)
+        {
+            _f(i, value);
+        }
+        _receiver.set_value(std::forward<V>(value));
+    }
+
+    void set_error(CURLcode error)
+    {
+        _receiver.set_error(error);
+    }
+
+    R _receiver;
+    std::size_t _count;
+    F _f;
+};
+
+template<typename S, typename F>
+struct Snd_BulkSender
+{
+    using value_type = typename S::value_type;
+
+    template<typename R>
+    Snd_Operation<S, Snd_BulkReceiver<R, F>> connect(R receiver) &&
+    {
+        return std::move(_sender).connect(Snd_BulkReceiver<R, F>{std::move(receiver), _count, std::move(_f)});
+    }
+
+    S _sender;
+    std::size_t _count;
+    F _f;
+};
+
+template<typename S, typename F>
+Snd_BulkSender<S, F> bulk(S sender, std::size_t count, F f)
+{
+    return Snd_BulkSender<S, F>{std::move(sender), count, std::move(f)};
+}
+
+// sync_wait(curl_async, s): drives the loop until `s` completes;
+// operation state lives on this stack; sleeps in curl_multi_poll().
+// Returns the value or the CURLcode `s` failed with
+template<typename V>
+struct Snd_SyncState
+{
+    std::optional<V> value;
+    CURLcode error = CURLE_OK;
+    bool done = false;
+};
+
+template<typename V>
+struct Snd_SyncReceiver
+{
+    void set_value(V value)
+    {
+        _state->value.emplace(std::move(value));
+        _state->done = true;
+    }
+
+    void set_error(CURLcode error)
+    {
+        _state->error = error;
+        _state->done = true;
+    }
+
+    Snd_SyncState<V>* _state;
+};
+
+template<typename S>
+std::expected<typename S::value_type, CURLcode> sync_wait(CURL_Async curl_async, S sender)
+{
+    using V = typename S::value_type;
+    Snd_SyncState<V> state;
+    Snd_Operation<S, Snd_SyncReceiver<V>> op = std::move(sender).connect(Snd_SyncReceiver<V>{&state});
+    op.start();
+    CURL_async_tick(curl_async);
+    while (!state.done)
+    {
+        // libcurl shortens the timeout to its own one, if any
+        CURL_async_wait(curl_async, std::chrono::milliseconds{1000});
+        CURL_async_tick(curl_async);
+    }
+    if (state.error != CURLE_OK)
+    {
+        return std::unexpected{state.error};
+    }
+    assert(state.value);
+    return std::move(*state.value);
+}
+
+int main()
+{
+    CURL_Async curl_async = CURL_async_create();
+    const char* url = "localhost:5001/file1.txt";
+
+    // 1. single request
+    std::expected<std::string, CURLcode> response = sync_wait(curl_async, curl_get_sender(curl_async, url));
+    if (!response)
+    {
+        std::println("sync_wait error: {}", curl_easy_strerror(response.error()));
+    }
+    assert(response);
+    std::println("sync_wait response: '{}'", *response);
+
+    // 2. fan-out pipeline: 3 requests in parallel, one of them chained
+    //    on the first response, checksum of each byte, total size
+    auto pipeline = then(
+        when_all(
+            curl_get_sender(curl_async, url)
+            , let_value(curl_get_sender(curl_async, url), [curl_async](std::string& first)
+            {
+                assert(!first.empty());
+                return curl_get_sender(curl_async, "localhost:5001/file1.txt");
+            })
+            , bulk(curl_get_sender(curl_async, url), 9, [](std::size_t i, const std::string& r)
+            {
+                assert(i < r.size());
+            }))
+        , [](std::tuple<std::string, std::string, std::string> responses)
+        {
+            return (std::get<0>(responses).size()
+                + std::get<1>(responses).size()
+                + std::get<2>(responses).size());
+        });
+    using Pipeline = decltype(pipeline);
+    const std::size_t op_size = sizeof(Snd_Operation<Pipeline, Snd_SyncReceiver<std::size_t>>);
+
+    const std::uint64_t allocations = g_App_allocations.load(std::memory_order_relaxed);
+    const std::expected<std::size_t, CURLcode> total = sync_wait(curl_async, std::move(pipeline));
+    const std::uint64_t used = g_App_allocations.load(std::memory_order_relaxed) - allocations;
+    if (!total)
+    {
+        std::println("sync_wait error: {}", curl_easy_strerror(total.error()));
+    }
+    assert(total);
+
+    CURL_async_destroy(curl_async);
+
+    std::println("pipeline total: {} bytes, operation state: {} bytes, allocations: {}"
+        , *total, op_size, used);
+}
@@ -0,0 +1,820 @@
+#include <print>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+// sleeps in curl_multi_poll() until socket activity, next timer or timeout
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout);
+
+// main async callback API
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+// one-shot timer, fired from tick(); returned id can be used to cancel it,
+// callback is not called then
+using CURL_AsyncTimerId = std::uint64_t;
+CURL_AsyncTimerId CURL_async_timer(CURL_Async curl_async
+    , std::chrono::milliseconds delay
+    , void* user_data
+    , void (*callback)(void* user_data));
+// no-op if already fired
+void CURL_async_timer_cancel(CURL_Async curl_async, CURL_AsyncTimerId timer);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+    using Clock = std::chrono::steady_clock;
+
+    struct Timer
+    {
+        Clock::time_point deadline;
+        CURL_AsyncTimerId id = 0;
+        void* user_data = nullptr;
+        void (*callback)(void* user_data) = nullptr;
+
+        bool operator>(const Timer& rhs) const
+        {
+            return (deadline > rhs.deadline);
+        }
+    };
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+    // cancelled timers stay in the heap until they reach the top
+    void drop_cancelled_timers();
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> _timers;
+    // started, not yet fired or cancelled
+    std::unordered_set<CURL_AsyncTimerId> _live_timers;
+    CURL_AsyncTimerId _next_timer_id = 1;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy);
+    }
+
+    const Clock::time_point now = Clock::now();
+    drop_cancelled_timers();
+    while (!_timers.empty() && (_timers.top().deadline <= now))
+    {
+        const Timer timer = _timers.top();
+        _timers.pop();
+        (void)_live_timers.erase(timer.id);
+        timer.callback(timer.user_data);
+        drop_cancelled_timers();
+    }
+}
+
+void CURL_AsyncScheduler::drop_cancelled_timers()
+{
+    while (!_timers.empty() && !_live_timers.contains(_timers.top().id))
+    {
+        _timers.pop();
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout)
+{
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(curl_async);
+    scheduler.drop_cancelled_timers();
+    if (!scheduler._timers.empty())
+    {
+        const auto until_timer = std::chrono::ceil<std::chrono::milliseconds>(
+            scheduler._timers.top().deadline - CURL_AsyncScheduler::Clock::now());
+        timeout = std::clamp(until_timer, std::chrono::milliseconds{0}, timeout);
+    }
+    const CURLMcode status = curl_multi_poll(scheduler._multi_curl
+        , nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    assert(status == CURLM_OK);
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to separate std::string
+    std::string* state = new std::string{};
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    CURL_scheduler(curl_async).add_request(curl_easy
+        , [state, user_data, callback](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(*state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+}
+
+CURL_AsyncTimerId CURL_async_timer(CURL_Async curl_async
+    , std::chrono::milliseconds delay
+    , void* user_data
+    , void (*callback)(void* user_data))
+{
+    assert(callback);
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(curl_async);
+    const CURL_AsyncTimerId id = scheduler._next_timer_id++;
+    (void)scheduler._live_timers.insert(id);
+    scheduler._timers.push(CURL_AsyncScheduler::Timer{
+        CURL_AsyncScheduler::Clock::now() + delay, id, user_data, callback});
+    return id;
+}
+
+void CURL_async_timer_cancel(CURL_Async curl_async, CURL_AsyncTimerId timer)
+{
+    (void)CURL_scheduler(curl_async)._live_timers.erase(timer);
+}
+
+// Reactive streams: publisher -> subscriber with demand signalled upstream
+// via request(n). Nobody emits more than was requested, so the source
+// keeps at most the outstanding demand in flight.
+// Single subscriber per publisher; objects are linked by reference and
+// must outlive the stream
+struct Rx_Subscription
+{
+    virtual void request(std::size_t n) = 0;
+    virtual void cancel() = 0;
+protected:
+    ~Rx_Subscription() = default;
+};
+
+template<typename T>
+struct Rx_Subscriber
+{
+    virtual void on_subscribe(Rx_Subscription& subscription) = 0;
+    virtual void on_next(T value) = 0;
+    virtual void on_complete() = 0;
+protected:
+    ~Rx_Subscriber() = default;
+};
+
+template<typename T>
+struct Rx_Publisher
+{
+    virtual void subscribe(Rx_Subscriber<T>& subscriber) = 0;
+protected:
+    ~Rx_Publisher() = default;
+};
+
+// source: GETs urls, in order of completion, never more than requested
+struct Rx_UrlSource final : Rx_Publisher<std::string>, Rx_Subscription
+{
+    Rx_UrlSource(CURL_Async curl_async, std::vector<std::string> urls)
+        : _curl_async{curl_async}
+        , _urls{std::move(urls)} {}
+
+    void subscribe(Rx_Subscriber<std::string>& subscriber) override
+    {
+        assert(!_subscriber);
+        _subscriber = &subscriber;
+        _subscriber->on_subscribe(*this);
+        pump();
+    }
+
+    void request(std::size_t n) override
+    {
+        _demand += n;
+        pump();
+    }
+
+    void cancel() override
+    {
+        _cancelled = true;
+    }
+
+    void pump()
+    {
+        // in flight requests count against the demand already
+        while (!_cancelled && (_next < _urls.size()) && (_in_flight < _demand))
+        {
+            ++_in_flight;
+            _max_in_flight = std::max(_max_in_flight, _in_flight);
+            CURL_async_get(_curl_async, _urls[_next++], this
+                , [](void* user_data, std::string response)
+            {
+                Rx_UrlSource& self = *static_cast<Rx_UrlSource*>(user_data);
+                --self._in_flight;
+                if (self._cancelled)
+                {
+                    return;
+                }
+                --self._demand;
+                self._subscriber->on_next(std::move(response));
+                self.pump();
+            });
+        }
+        if (!_cancelled && !_completed && (_next == _urls.size()) && (_in_flight == 0))
+        {
+            _completed = true;
+            _subscriber->on_complete();
+        }
+    }
+
+    CURL_Async _curl_async{};
+    std::vector<std::string> _urls;
+    Rx_Subscriber<std::string>* _subscriber = nullptr;
+    std::size_t _next = 0;
+    std::size_t _demand = 0;
+    std::size_t _in_flight = 0;
+    std::size_t _max_in_flight = 0;
+    bool _cancelled = false;
+    bool _completed = false;
+};
+
+// common part of 1:1 operators: demand and cancel go upstream as is
+template<typename In, typename Out>
+struct Rx_Operator : Rx_Publisher<Out>, Rx_Subscriber<In>, Rx_Subscription
+{
+    explicit Rx_Operator(Rx_Publisher<In>& upstream)
+        : _upstream{upstream} {}
+
+    void subscribe(Rx_Subscriber<Out>& subscriber) override
+    {
+        assert(!_downstream);
+        _downstream = &subscriber;
+        _upstream.subscribe(*this);
+    }
+
+    void on_subscribe(Rx_Subscription& subscription) override
+    {
+        _subscription = &subscription;
+        _downstream->on_subscribe(*this);
+    }
+
+    void on_complete() override
+    {
+        _downstream->on_complete();
+    }
+
+    void request(std::size_t n) override
+    {
+        _subscription->request(n);
+    }
+
+    void cancel() override
+    {
+        _subscription->cancel();
+    }
+
+    Rx_Publisher<In>& _upstream;
+    Rx_Subscriber<Out>* _downstream = nullptr;
+    Rx_Subscription* _subscription = nullptr;
+protected:
+    ~Rx_Operator() = default;
+};
+
+template<typename In, typename Out, typename F>
+struct Rx_Map final : Rx_Operator<In, Out>
+{
+    Rx_Map(Rx_Publisher<In>& upstream, F f)
+        : Rx_Operator<In, Out>{upstream}
+        , _f{std::move(f)} {}
+
+    void on_next(In value) override
+    {
+        this->_downstream->on_next(_f(std::move(value)));
+    }
+
+    F _f;
+};
+
+template<typename Out, typename In, typename F>
+Rx_Map<In, Out, F> Rx_map(Rx_Publisher<In>& upstream, F f)
+{
+    return Rx_Map<In, Out, F>{upstream, std::move(f)};
+}
+
+template<typename T, typename F>
+struct Rx_Filter final : Rx_Operator<T, T>
+{
+    Rx_Filter(Rx_Publisher<T>& upstream, F predicate)
+        : Rx_Operator<T, T>{upstream}
+        , _predicate{std::move(predicate)} {}
+
+    void on_next(T value) override
+    {
+        if (_predicate(value))
+        {
+            this->_downstream->on_next(std::move(value));
+        }
+        else
+        {   // dropped: downstream still waits for one, ask again
+            this->_subscription->request(1);
+        }
+    }
+
+    F _predicate;
+};
+
+template<typename T, typename F>
+Rx_Filter<T, F> Rx_filter(Rx_Publisher<T>& upstream, F predicate)
+{
+    return Rx_Filter<T, F>{upstream, std::move(predicate)};
+}
+
+// buffer(n): groups of n; request(k) becomes upstream request(k * n)
+template<typename T>
+struct Rx_Buffer final : Rx_Operator<T, std::vector<T>>
+{
+    Rx_Buffer(Rx_Publisher<T>& upstream, std::size_t count)
+        : Rx_Operator<T, std::vector<T>>{upstream}
+        , _count{count}
+    {
+        assert(count > 0);
+        _buffer.reserve(count);
+    }
+
+    void on_next(T value) override
+    {
+        _buffer.push_back(std::move(value));
+        if (_buffer.size() == _count)
+        {
+            flush();
+        }
+    }
+
+    void on_complete() override
+    {
+        if (!_buffer.empty())
+        {   // last partial group
+            flush();
+        }
+        this->_downstream->on_complete();
+    }
+
+    void request(std::size_t n) override
+    {
+        this->_subscription->request(n * _count);
+    }
+
+    void flush()
+    {
+        std::vector<T> group;
+        group.reserve(_count);
+        group.swap(_buffer);
+        this->_downstream->on_next(std::move(group));
+    }
+
+    std::size_t _count = 0;
+    std::vector<T> _buffer;
+};
+
+// throttle(interval): upstream is asked for one item at a time and not
+// more often than once per interval, so requests themselves are paced
+template<typename T>
+struct Rx_Throttle final : Rx_Operator<T, T>
+{
+    using Clock = std::chrono::steady_clock;
+
+    Rx_Throttle(Rx_Publisher<T>& upstream, CURL_Async curl_async, std::chrono::milliseconds interval)
+        : Rx_Operator<T, T>{upstream}
+        , _curl_async{curl_async}
+        , _interval{interval} {}
+    // no copy, no move: the armed timer points to us
+    Rx_Throttle(const Rx_Throttle&) = delete;
+    ~Rx_Throttle()
+    {
+        cancel_timer();
+    }
+
+    void on_next(T value) override
+    {
+        _requested = false;
+        this->_downstream->on_next(std::move(value));
+        pump();
+    }
+
+    void on_complete() override
+    {
+        cancel_timer();
+        this->_downstream->on_complete();
+    }
+
+    void request(std::size_t n) override
+    {
+        _demand += n;
+        pump();
+    }
+
+    void cancel() override
+    {
+        cancel_timer();
+        this->_subscription->cancel();
+    }
+
+    void cancel_timer()
+    {
+        if (_timer != 0)
+        {
+            CURL_async_timer_cancel(_curl_async, std::exchange(_timer, 0));
+        }
+    }
+
+    void pump()
+    {
+        if (_requested || (_timer != 0) || (_demand == 0))
+        {
+            return;
+        }
+        const Clock::time_point now = Clock::now();
+        if (now < _next_allowed)
+        {
+            _timer = CURL_async_timer(_curl_async
+                , std::chrono::ceil<std::chrono::milliseconds>(_next_allowed - now)
+                , this, [](void* user_data)
+            {
+                Rx_Throttle& self = *static_cast<Rx_Throttle*>(user_data);
+                self._timer = 0;
+                self.pump();
+            });
+            return;
+        }
+        _requested = true;
+        --_demand;
+        _next_allowed = now + _interval;
+        this->_subscription->request(1);
+    }
+
+    CURL_Async _curl_async{};
+    std::chrono::milliseconds _interval{};
+    Clock::time_point _next_allowed{};
+    std::size_t _demand = 0;
+    // armed pacing timer, 0 if none
+    CURL_AsyncTimerId _timer = 0;
+    bool _requested = false;
+};
+
+// merge(sources, max_concurrency): at most max sources subscribed at once,
+// each asked for one item at a time while downstream demand allows
+template<typename T>
+struct Rx_Merge final : Rx_Publisher<T>, Rx_Subscription
+{
+    struct Inner final : Rx_Subscriber<T>
+    {
+        void on_subscribe(Rx_Subscription& subscription) override
+        {
+            _subscription = &subscription;
+        }
+
+        void on_next(T value) override
+        {
+            _requested = false;
+            --_merge->_outstanding;
+            _merge->emit(std::move(value));
+        }
+
+        void on_complete() override
+        {
+            _done = true;
+            if (_requested)
+            {
+                _requested = false;
+                --_merge->_outstanding;
+            }
+            _merge->on_inner_complete();
+        }
+
+        Rx_Merge* _merge = nullptr;
+        Rx_Subscription* _subscription = nullptr;
+        bool _requested = false;
+        bool _done = false;
+    };
+
+    Rx_Merge(std::vector<Rx_Publisher<T>*> sources, std::size_t max_concurrency)
+        : _sources{std::move(sources)}
+        , _inners(_sources.size())
+        , _max_concurrency{max_concurrency}
+    {
+        assert(max_concurrency > 0);
+        for (Inner& inner : _inners)
+        {
+            inner._merge = this;
+        }
+    }
+    // no copy, no move: inners point back
+    Rx_Merge(const Rx_Merge&) = delete;
+
+    void subscribe(Rx_Subscriber<T>& subscriber) override
+    {
+        assert(!_downstream);
+        _downstream = &subscriber;
+        _downstream->on_subscribe(*this);
+        activate();
+        // demand may have come from on_subscribe() above
+        drain();
+        if (_sources.empty())
+        {
+            _downstream->on_complete();
+        }
+    }
+
+    void request(std::size_t n) override
+    {
+        _demand += n;
+        drain();
+    }
+
+    void cancel() override
+    {
+        _cancelled = true;
+        for (std::size_t i = _first_active; i < _next_source; ++i)
+        {
+            if (!_inners[i]._done)
+            {
+                _inners[i]._subscription->cancel();
+            }
+        }
+    }
+
+    void activate()
+    {
+        while (!_cancelled && (_active < _max_concurrency) && (_next_source < _sources.size()))
+        {
+            // advance first: a source may complete right inside subscribe(),
+            // re-entering activate() through on_inner_complete()
+            const std::size_t i = _next_source++;
+            ++_active;
+            _sources[i]->subscribe(_inners[i]);
+        }
+    }
+
+    void drain()
+    {
+        for (std::size_t i = _first_active; (i < _next_source) && (_outstanding < _demand); ++i)
+        {
+            Inner& inner = _inners[i];
+            if (inner._done || inner._requested)
+            {
+                continue;
+            }
+            inner._requested = true;
+            ++_outstanding;
+            inner._subscription->request(1);
+        }
+    }
+
+    void emit(T value)
+    {
+        --_demand;
+        _downstream->on_next(std::move(value));
+        drain();
+    }
+
+    void on_inner_complete()
+    {
+        --_active;
+        while ((_first_active < _next_source) && _inners[_first_active]._done)
+        {
+            ++_first_active;
+        }
+        activate();
+        drain();
+        if (!_completed && (_active == 0) && (_next_source == _sources.size()))
+        {
+            _completed = true;
+            _downstream->on_complete();
+        }
+    }
+
+    std::vector<Rx_Publisher<T>*> _sources;
+    std::vector<Inner> _inners;
+    Rx_Subscriber<T>* _downstream = nullptr;
+    std::size_t _max_concurrency = 0;
+    std::size_t _active = 0;
+    std::size_t _first_active = 0;
+    std::size_t _next_source = 0;
+    std::size_t _demand = 0;
+    std::size_t _outstanding = 0;
+    bool _cancelled = false;
+    bool _completed = false;
+};
+
+// terminal subscriber: keeps `window` items requested, handles each with `f`
+template<typename T, typename F>
+struct Rx_Sink final : Rx_Subscriber<T>
+{
+    Rx_Sink(std::size_t window, F f)
+        : _window{window}
+        , _f{std::move(f)} {}
+
+    void on_subscribe(Rx_Subscription& subscription) override
+    {
+        _subscription = &subscription;
+        _subscription->request(_window);
+    }
+
+    void on_next(T value) override
+    {
+        _f(std::move(value));
+        _subscription->request(1);
+    }
+
+    void on_complete() override
+    {
+        _done = true;
+    }
+
+    std::size_t _window = 0;
+    F _f;
+    Rx_Subscription* _subscription = nullptr;
+    bool _done = false;
+};
+
+template<typename T, typename F>
+Rx_Sink<T, F> Rx_sink(std::size_t window, F f)
+{
+    return Rx_Sink<T, F>{window, std::move(f)};
+}
+
+template<typename Sink>
+static void Rx_RunUntilDone(CURL_Async curl_async, const Sink& sink)
+{
+    CURL_async_tick(curl_async);
+    while (!sink._done)
+    {
+        CURL_async_wait(curl_async, std::chrono::milliseconds{1000});
+        CURL_async_tick(curl_async);
+    }
+}
+
+int main()
+{
+    CURL_Async curl_async = CURL_async_create();
+
+    // 1. ingestion: 200 urls -> size -> non-empty -> groups of 10;
+    //    sink absorbs 2 groups at a time, so at most 20 transfers in flight
+    {
+        Rx_UrlSource source{curl_async, std::vector<std::string>(200, "localhost:5001/file1.txt")};
+        auto sizes = Rx_map<std::size_t>(source, [](std::string response)
+        {
+            return response.size();
+        });
+        auto non_empty = Rx_filter(sizes, [](std::size_t size)
+        {
+            return (size > 0);
+        });
+        Rx_Buffer<std::size_t> groups{non_empty, 10};
+        std::size_t total = 0;
+        std::size_t batches = 0;
+        auto sink = Rx_sink<std::vector<std::size_t>>(2, [&](std::vector<std::size_t> group)
+        {
+            ++batches;
+            for (std::size_t size : group)
+            {
+                total += size;
+            }
+        });
+        groups.subscribe(sink);
+        Rx_RunUntilDone(curl_async, sink);
+        std::println("ingested: {} bytes in {} batches, max in flight: {}"
+            , total, batches, source._max_in_flight);
+    }
+
+    // 2. merge 4 sources (and an empty one), 2 at a time, then throttled to 1 per 10ms
+    {
+        Rx_UrlSource empty{curl_async, {}};
+        Rx_UrlSource s1{curl_async, std::vector<std::string>(5, "localhost:5001/file1.txt")};
+        Rx_UrlSource s2{curl_async, std::vector<std::string>(5, "localhost:5001/file1.txt")};
+        Rx_UrlSource s3{curl_async, std::vector<std::string>(5, "localhost:5001/file1.txt")};
+        Rx_UrlSource s4{curl_async, std::vector<std::string>(5, "localhost:5001/file1.txt")};
+        Rx_Merge<std::string> merged{{&empty, &s1, &s2, &s3, &s4}, 2};
+        Rx_Throttle<std::string> throttled{merged, curl_async, std::chrono::milliseconds{10}};
+        std::size_t count = 0;
+        auto sink = Rx_sink<std::string>(4, [&](std::string response)
+        {
+            assert(response == "content 1");
+            ++count;
+        });
+        const auto start = std::chrono::steady_clock::now();
+        throttled.subscribe(sink);
+        Rx_RunUntilDone(curl_async, sink);
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        std::println("merged: {} responses in {} ms", count, elapsed.count());
+    }
+
+    CURL_async_destroy(curl_async);
+}
@@ -0,0 +1,403 @@
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// Multicast event (delegate): plain function pointer + user_data pairs,
+// first kInline stored in place; emit() is a loop of indirect calls,
+// no virtual dispatch, no std::function, no allocation up to kInline
+template<typename... Args>
+struct CURL_Event
+{
+    using Fn = void (*)(void* user_data, Args... args);
+    static constexpr std::size_t kInline = 4;
+
+    struct Subscriber
+    {
+        Fn fn = nullptr;
+        void* user_data = nullptr;
+    };
+
+    CURL_Event() = default;
+    // no copy, no move: subscribers may hold pointers to the owner
+    CURL_Event(const CURL_Event&) = delete;
+
+    void subscribe(void* user_data, Fn fn)
+    {
+        assert(fn);
+        assert(!_emitting);
+        if (_size < kInline)
+        {
+            _inline[_size] = Subscriber{fn, user_data};
+        }
+        else
+        {
+            _overflow.push_back(Subscriber{fn, user_data});
+        }
+        ++_size;
+    }
+
+    void unsubscribe(void* user_data, Fn fn)
+    {
+        assert(!_emitting);
+        for (std::size_t i = 0; i < _size; ++i)
+        {
+            Subscriber& subscriber = at(i);
+            if ((subscriber.fn != fn) || (subscriber.user_data != user_data))
+            {
+                continue;
+            }
+            // keep subscription order
+            for (std::size_t j = i + 1; j < _size; ++j)
+            {
+                at(j - 1) = at(j);
+            }
+            --_size;
+            if (_size >= kInline)
+            {
+                _overflow.pop_back();
+            }
+            return;
+        }
+    }
+
+    void emit(Args... args)
+    {
+        _emitting = true;
+        const std::size_t count = std::min(_size, kInline);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            _inline[i].fn(_inline[i].user_data, args...);
+        }
+        for (const Subscriber& subscriber : _overflow)
+        {
+            subscriber.fn(subscriber.user_data, args...);
+        }
+        _emitting = false;
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    Subscriber& at(std::size_t i)
+    {
+        return (i < kInline) ? _inline[i] : _overflow[i - kInline];
+    }
+
+    Subscriber _inline[kInline];
+    std::size_t _size = 0;
+    std::vector<Subscriber> _overflow;
+    bool _emitting = false;
+};
+
+struct CURL_SchedulerEvents;
+
+// per-request events; object is alive until on_complete/on_error returns
+struct CURL_Request
+{
+    CURL_Event<std::string_view> on_headers; // one header line, with CRLF
+    CURL_Event<std::string_view> on_data;
+    CURL_Event<long> on_complete;            // HTTP response code
+    CURL_Event<CURLcode> on_error;
+
+    std::string url;
+    CURL* _curl_easy = nullptr;
+    CURL_SchedulerEvents* _scheduler_events = nullptr;
+};
+
+// same events for every request of a scheduler: metrics, logging
+struct CURL_SchedulerEvents
+{
+    CURL_Event<CURL_Request&, std::string_view> on_headers;
+    CURL_Event<CURL_Request&, std::string_view> on_data;
+    CURL_Event<CURL_Request&, long> on_complete;
+    CURL_Event<CURL_Request&, CURLcode> on_error;
+};
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+CURL_SchedulerEvents& CURL_async_events(CURL_Async curl_async);
+
+// stateful/implicit callbacks API: nothing happens before the next tick,
+// subscribe to returned request's events right after the call
+CURL_Request& CURL_async_request(CURL_Async curl_async, const std::string& url);
+
+// only ours: libcurl still does its own malloc() per transfer
+static std::atomic<std::uint64_t> g_App_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    g_App_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    void tick();
+    CURL_Request& add_request(const std::string& url);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    CURL_SchedulerEvents _events;
+};
+
+static size_t CURL_OnHeaderCallback(char* ptr, size_t size, size_t nitems, void* data)
+{
+    CURL_Request& request = *static_cast<CURL_Request*>(data);
+    const std::string_view line{ptr, size * nitems};
+    request._scheduler_events->on_headers.emit(request, line);
+    request.on_headers.emit(line);
+    return (size * nitems);
+}
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    CURL_Request& request = *static_cast<CURL_Request*>(data);
+    const std::string_view chunk{static_cast<const char*>(ptr), size * nmemb};
+    request._scheduler_events->on_data.emit(request, chunk);
+    request.on_data.emit(chunk);
+    return (size * nmemb);
+}
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        const CURLcode result = m->data.result;
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        char* private_data = nullptr;
+        CURLcode status_ = curl_easy_getinfo(curl_easy, CURLINFO_PRIVATE, &private_data);
+        assert(status_ == CURLE_OK);
+        CURL_Request* request = reinterpret_cast<CURL_Request*>(private_data);
+        assert(request);
+
+        if (result != CURLE_OK)
+        {
+            _events.on_error.emit(*request, result);
+            request->on_error.emit(result);
+        }
+        else
+        {
+            long response_code = -1;
+            status_ = curl_easy_getinfo(curl_easy, CURLINFO_RESPONSE_CODE, &response_code);
+            assert(status_ == CURLE_OK);
+            _events.on_complete.emit(*request, response_code);
+            request->on_complete.emit(response_code);
+        }
+        curl_easy_cleanup(curl_easy);
+        delete request;
+    }
+}
+
+CURL_Request& CURL_AsyncScheduler::add_request(const std::string& url)
+{
+    CURL_Request* request = new CURL_Request{};
+    request->url = url;
+    request->_scheduler_events = &_events;
+
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    request->_curl_easy = curl_easy;
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_PRIVATE, request);
+    assert(status == CURLE_OK);
+
+    // 2. headers and data go to events, nothing is buffered
+    status = curl_easy_setopt(curl_easy, CURLOPT_HEADERFUNCTION, CURL_OnHeaderCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_HEADERDATA, request);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, request);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    const CURLMcode status_ = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status_ == CURLM_OK);
+    return *request;
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+CURL_SchedulerEvents& CURL_async_events(CURL_Async curl_async)
+{
+    return CURL_scheduler(curl_async)._events;
+}
+
+CURL_Request& CURL_async_request(CURL_Async curl_async, const std::string& url)
+{
+    return CURL_scheduler(curl_async).add_request(url);
+}
+
+// metrics layer: scheduler-wide
+struct App_Metrics
+{
+    std::size_t header_lines = 0;
+    std::size_t bytes = 0;
+    std::size_t completed = 0;
+    std::size_t errors = 0;
+};
+
+// business logic: per request
+struct App_Download
+{
+    std::string body;
+    long response_code = -1;
+    bool done = false;
+};
+
+int main()
+{
+    CURL_Async curl_async = CURL_async_create();
+
+    App_Metrics metrics;
+    CURL_SchedulerEvents& events = CURL_async_events(curl_async);
+    events.on_headers.subscribe(&metrics, [](void* user_data, CURL_Request&, std::string_view)
+    {
+        ++static_cast<App_Metrics*>(user_data)->header_lines;
+    });
+    events.on_data.subscribe(&metrics, [](void* user_data, CURL_Request&, std::string_view chunk)
+    {
+        static_cast<App_Metrics*>(user_data)->bytes += chunk.size();
+    });
+    events.on_complete.subscribe(&metrics, [](void* user_data, CURL_Request&, long)
+    {
+        ++static_cast<App_Metrics*>(user_data)->completed;
+    });
+    events.on_error.subscribe(&metrics, [](void* user_data, CURL_Request& request, CURLcode error)
+    {
+        ++static_cast<App_Metrics*>(user_data)->errors;
+        std::println("error: {} for {}", curl_easy_strerror(error), request.url);
+    });
+
+    App_Download download;
+    CURL_Request& request = CURL_async_request(curl_async, "localhost:5001/file1.txt");
+    const std::uint64_t allocations = g_App_allocations.load(std::memory_order_relaxed);
+    // logging
+    request.on_headers.subscribe(nullptr, [](void*, std::string_view line)
+    {
+        if (line.starts_with("HTTP/"))
+        {
+            std::println("status line: '{}'", line.substr(0, line.find_first_of("\r\n")));
+        }
+    });
+    // business logic, 3 more subscribers
+    request.on_data.subscribe(&download, [](void* user_data, std::string_view chunk)
+    {
+        static_cast<App_Download*>(user_data)->body.append(chunk);
+    });
+    request.on_complete.subscribe(&download, [](void* user_data, long response_code)
+    {
+        App_Download& download_ = *static_cast<App_Download*>(user_data);
+        download_.response_code = response_code;
+        download_.done = true;
+    });
+    request.on_error.subscribe(&download, [](void* user_data, CURLcode)
+    {
+        static_cast<App_Download*>(user_data)->done = true;
+    });
+    const std::uint64_t subscribe_allocations = g_App_allocations.load(std::memory_order_relaxed) - allocations;
+
+    while (!download.done)
+    {
+        CURL_async_tick(curl_async);
+    }
+    CURL_async_destroy(curl_async);
+
+    assert(download.response_code == 200L);
+    std::println("response: '{}'", download.body);
+    std::println("metrics: {} header lines, {} bytes, {} completed, {} errors"
+        , metrics.header_lines, metrics.bytes, metrics.completed, metrics.errors);
+    std::println("allocations for subscribing: {}", subscribe_allocations);
+}
@@ -0,0 +1,514 @@
+#include <print>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <coroutine>
+#include <utility>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+
+// main async callback API; returned id can be used to cancel the request,
+// callback is not called then
+using CURL_AsyncRequestId = void*;
+CURL_AsyncRequestId CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+void CURL_async_cancel(CURL_Async curl_async, CURL_AsyncRequestId request);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    // CURLE_ABORTED_BY_CALLBACK when cancelled
+    using Callback = std::function<void (CURL* curl_easy, CURLcode result)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+    void cancel_request(CURL* curl_easy);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    assert(_curl_to_callback.empty());
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        const CURLcode result = m->data.result;
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy, result);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+void CURL_AsyncScheduler::cancel_request(CURL* curl_easy)
+{
+    auto it = _curl_to_callback.find(curl_easy);
+    assert(it != _curl_to_callback.end());
+    const CURLMcode status = curl_multi_remove_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    Callback callback = std::move(it->second);
+    (void)_curl_to_callback.erase(it);
+    callback(curl_easy, CURLE_ABORTED_BY_CALLBACK);
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+CURL_AsyncRequestId CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to separate std::string
+    std::string* state = new std::string{};
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    CURL_scheduler(curl_async).add_request(curl_easy
+        , [state, user_data, callback](CURL* curl_easy_, CURLcode result)
+    {
+        if (result == CURLE_ABORTED_BY_CALLBACK)
+        {   // cancelled: clean up, nobody to notify
+            curl_easy_cleanup(curl_easy_);
+            delete state;
+            return;
+        }
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(*state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+    return curl_easy;
+}
+
+void CURL_async_cancel(CURL_Async curl_async, CURL_AsyncRequestId request)
+{
+    assert(request);
+    CURL_scheduler(curl_async).cancel_request(static_cast<CURL*>(request));
+}
+
+struct Co_Scope;
+
+struct Co_Task
+{
+    struct promise_type;
+    using co_handle = std::coroutine_handle<promise_type>;
+
+    // owned by Co_Scope: frame is destroyed right at the final suspend
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(co_handle coro) noexcept;
+
+        void await_resume() noexcept
+        {
+        }
+    };
+
+    struct promise_type
+    {
+        Co_Task get_return_object()
+        {
+            return Co_Task{co_handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()
+        {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+            // yeah, we return void. Nothing to do
+        }
+
+        void unhandled_exception()
+        {
+            // crash, no exceptions handling
+            assert(false);
+        }
+
+        // intrusive node of Co_Scope's children list, lives in the frame
+        Co_Scope* _scope = nullptr;
+        promise_type* _prev = nullptr;
+        promise_type* _next = nullptr;
+        // set by the awaiter while suspended on something cancellable
+        void (*_cancel)(void* context) = nullptr;
+        void* _cancel_context = nullptr;
+    };
+
+    Co_Task(co_handle coro)
+        : _coro{coro} {}
+    Co_Task(Co_Task&& rhs) noexcept
+        : _coro{std::exchange(rhs._coro, {})} { }
+    Co_Task(const Co_Task&) = delete;
+    ~Co_Task() noexcept
+    {
+        if (_coro)
+        {
+            _coro.destroy();
+        }
+    }
+
+    void resume()
+    {
+        assert(_coro);
+        assert(!_coro.done());
+        _coro.resume();
+    }
+
+    bool is_in_progress() const
+    {
+        assert(_coro);
+        return !_coro.done();
+    }
+
+    co_handle _coro;
+};
+
+// Structured concurrency: owns detached children; on destruction, cancels
+// their requests and destroys their frames, so nothing can resume a dead
+// coroutine. Bookkeeping is an intrusive list through children's promises
+struct Co_Scope
+{
+    Co_Scope() = default;
+    // no copy, no move: children point to it
+    Co_Scope(const Co_Scope&) = delete;
+    ~Co_Scope() noexcept
+    {
+        // a joiner is only left when its own frame, holding this scope,
+        // is being destroyed: it must not be resumed
+        _joiner = {};
+        cancel();
+    }
+
+    // starts `task` right away; the scope owns it from now on
+    void spawn(Co_Task task)
+    {
+        Co_Task::co_handle coro = std::exchange(task._coro, {});
+        assert(coro);
+        Co_Task::promise_type& promise = coro.promise();
+        assert(!promise._scope);
+        promise._scope = this;
+        promise._next = _children;
+        if (_children)
+        {
+            _children->_prev = &promise;
+        }
+        _children = &promise;
+        ++_size;
+        ++_spawned;
+        coro.resume();
+    }
+
+    // cancels in-flight requests of all children and destroys them
+    void cancel()
+    {
+        while (Co_Task::promise_type* promise = _children)
+        {
+            if (promise->_cancel)
+            {
+                std::exchange(promise->_cancel, nullptr)(promise->_cancel_context);
+            }
+            unlink(*promise);
+            ++_cancelled;
+            Co_Task::co_handle::from_promise(*promise).destroy();
+        }
+        if (_joiner)
+        {
+            std::exchange(_joiner, {}).resume();
+        }
+    }
+
+    struct JoinAwaiter
+    {
+        bool await_ready()
+        {
+            return (_scope._size == 0);
+        }
+
+        void await_suspend(std::coroutine_handle<> coro)
+        {
+            assert(!_scope._joiner);
+            _scope._joiner = coro;
+        }
+
+        void await_resume()
+        {
+        }
+
+        Co_Scope& _scope;
+    };
+
+    // `co_await scope.join()`: resumed when the last child finishes
+    JoinAwaiter join()
+    {
+        return JoinAwaiter{*this};
+    }
+
+    void unlink(Co_Task::promise_type& promise)
+    {
+        if (promise._prev)
+        {
+            promise._prev->_next = promise._next;
+        }
+        else
+        {
+            _children = promise._next;
+        }
+        if (promise._next)
+        {
+            promise._next->_prev = promise._prev;
+        }
+        promise._prev = nullptr;
+        promise._next = nullptr;
+        promise._scope = nullptr;
+        --_size;
+    }
+
+    std::coroutine_handle<> on_child_done(Co_Task::co_handle coro)
+    {
+        unlink(coro.promise());
+        ++_completed;
+        coro.destroy();
+        if ((_size == 0) && _joiner)
+        {
+            return std::exchange(_joiner, {});
+        }
+        return std::noop_coroutine();
+    }
+
+    Co_Task::promise_type* _children = nullptr;
+    std::size_t _size = 0;
+    std::coroutine_handle<> _joiner;
+    // stats
+    std::size_t _spawned = 0;
+    std::size_t _completed = 0;
+    std::size_t _cancelled = 0;
+};
+
+std::coroutine_handle<> Co_Task::FinalAwaiter::await_suspend(co_handle coro) noexcept
+{
+    if (Co_Scope* scope = coro.promise()._scope)
+    {
+        return scope->on_child_done(coro);
+    }
+    // not in a scope: Co_Task owner destroys it
+    return std::noop_coroutine();
+}
+
+struct Co_CurlAsync
+{
+    CURL_Async _curl_async{};
+    std::string _url;
+    std::coroutine_handle<Co_Task::promise_type> _coro;
+    CURL_AsyncRequestId _request = nullptr;
+    std::string _response;
+
+    bool await_ready()
+    { // 1. CURL_async_get() is not yet started, force coroutine suspend:
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<Co_Task::promise_type> coro)
+    { // 2. remember coroutine handle, start request, resume on finish:
+        _coro = coro;
+
+        _request = CURL_async_get(_curl_async, _url, this
+            , [](void* user_data, std::string response)
+        {
+            Co_CurlAsync& self = *static_cast<Co_CurlAsync*>(user_data);
+            self._coro.promise()._cancel = nullptr;
+            self._request = nullptr;
+            self._response = std::move(response);
+            self._coro.resume();
+        });
+        // let the owning scope cancel the request before frame destruction
+        Co_Task::promise_type& promise = coro.promise();
+        promise._cancel_context = this;
+        promise._cancel = [](void* context)
+        {
+            Co_CurlAsync& self = *static_cast<Co_CurlAsync*>(context);
+            CURL_async_cancel(self._curl_async, std::exchange(self._request, nullptr));
+        };
+    }
+
+    std::string await_resume()
+    { // 3. after resume, return response:
+        return std::move(_response);
+    }
+};
+
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url)
+{
+    Co_CurlAsync awaiter;
+    awaiter._curl_async = curl_async;
+    awaiter._url = url;
+    return awaiter;
+}
+
+static Co_Task coro_fetch(CURL_Async curl_async, std::size_t& bytes)
+{
+    const std::string response = co_await CURL_await_get(
+        curl_async, "localhost:5001/file1.txt");
+    bytes += response.size();
+    co_return;
+}
+
+static Co_Task coro_main(CURL_Async curl_async)
+{
+    // 1. thousands of fire-and-forget fetches, joined
+    Co_Scope scope;
+    std::size_t bytes = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        scope.spawn(coro_fetch(curl_async, bytes));
+    }
+    co_await scope.join();
+    std::println("joined: {} spawned, {} completed, {} bytes"
+        , scope._spawned, scope._completed, bytes);
+
+    // 2. what crashed 0x_cpp_coro_await_curl_crash: leave with requests
+    //    in flight; scope cancels them, nothing resumes destroyed frames
+    std::size_t cancelled = 0;
+    {
+        Co_Scope early_exit;
+        for (int i = 0; i < 10; ++i)
+        {
+            early_exit.spawn(coro_fetch(curl_async, bytes));
+        }
+        early_exit.cancel();
+        cancelled = early_exit._cancelled;
+    }
+    std::println("early exit: {} cancelled", cancelled);
+    co_return;
+}
+
+int main()
+{
+    CURL_Async curl_async = CURL_async_create();
+    Co_Task task = coro_main(curl_async);
+    task.resume();
+    while (task.is_in_progress())
+    {
+        CURL_async_tick(curl_async);
+    }
+    // nothing left in flight to call back into destroyed coroutines
+    for (int i = 0; i < 100; ++i)
+    {
+        CURL_async_tick(curl_async);
+    }
+    CURL_async_destroy(curl_async);
+}
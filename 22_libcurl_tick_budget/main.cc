@@ -0,0 +1,260 @@
+#include <print>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <optional>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+// dispatches every completed request
+void CURL_async_tick(CURL_Async curl_async);
+// dispatches completed requests' callbacks until `budget` is spent (at least
+// one, if any); the rest are kept for the next call. Returns how many
+// completed requests are still waiting for their callback
+std::size_t CURL_async_tick_budget(CURL_Async curl_async, std::chrono::microseconds budget);
+
+// main async callback API
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+    using Clock = std::chrono::steady_clock;
+
+    // no budget when `deadline` is empty
+    std::size_t tick(std::optional<Clock::time_point> deadline);
+    void add_request(CURL* curl_easy, Callback on_finish);
+
+    struct Completed
+    {
+        CURL* curl_easy = nullptr;
+        Callback callback;
+    };
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+    // finished transfers whose callback didn't fit into the budget yet
+    std::deque<Completed> _backlog;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+std::size_t CURL_AsyncScheduler::tick(std::optional<Clock::time_point> deadline)
+{
+    // 1. libcurl bookkeeping is cheap and always done in full,
+    //    sockets keep being serviced even with a backlog
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        assert(it->second);
+        _backlog.push_back(Completed{curl_easy, std::move(it->second)});
+        (void)_curl_to_callback.erase(it);
+    }
+
+    // 2. callbacks, oldest first, while there is time left
+    bool first = true;
+    while (!_backlog.empty())
+    {
+        if (!first && deadline && (Clock::now() >= *deadline))
+        {
+            break;
+        }
+        first = false;
+        Completed completed = std::move(_backlog.front());
+        _backlog.pop_front();
+        completed.callback(completed.curl_easy);
+    }
+    return _backlog.size();
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    (void)CURL_scheduler(curl_async).tick(std::nullopt);
+}
+
+std::size_t CURL_async_tick_budget(CURL_Async curl_async, std::chrono::microseconds budget)
+{
+    return CURL_scheduler(curl_async).tick(CURL_AsyncScheduler::Clock::now() + budget);
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to separate std::string
+    std::string* state = new std::string{};
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    CURL_scheduler(curl_async).add_request(curl_easy
+        , [state, user_data, callback](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(*state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+}
+
+// frame-based application: one tick per frame
+using App_Clock = std::chrono::steady_clock;
+
+struct App_Frames
+{
+    std::size_t responses = 0;
+    std::size_t frames = 0;
+    std::size_t max_backlog = 0;
+    App_Clock::duration max_frame{};
+};
+
+static void App_OnResponse(void* user_data, std::string response)
+{
+    App_Frames& app = *static_cast<App_Frames*>(user_data);
+    assert(!response.empty());
+    // heavy parsing
+    const App_Clock::time_point end = App_Clock::now() + std::chrono::microseconds{500};
+    while (App_Clock::now() < end)
+    {
+    }
+    ++app.responses;
+}
+
+static void App_Run(std::optional<std::chrono::microseconds> budget)
+{
+    const std::size_t kRequests = 100;
+    CURL_Async curl_async = CURL_async_create();
+    App_Frames app;
+    for (std::size_t i = 0; i < kRequests; ++i)
+    {
+        CURL_async_get(curl_async, "localhost:5001/file1.txt", &app, &App_OnResponse);
+    }
+    while (app.responses < kRequests)
+    {
+        const App_Clock::time_point start = App_Clock::now();
+        if (budget)
+        {
+            const std::size_t backlog = CURL_async_tick_budget(curl_async, *budget);
+            app.max_backlog = std::max(app.max_backlog, backlog);
+        }
+        else
+        {
+            CURL_async_tick(curl_async);
+        }
+        app.max_frame = std::max(app.max_frame, App_Clock::now() - start);
+        ++app.frames;
+    }
+    CURL_async_destroy(curl_async);
+
+    std::println("budget {} us: {} responses in {} frames, max frame {} us, max backlog {}"
+        , budget ? budget->count() : -1
+        , app.responses, app.frames
+        , std::chrono::duration_cast<std::chrono::microseconds>(app.max_frame).count()
+        , app.max_backlog);
+}
+
+int main()
+{
+    App_Run(std::nullopt);
+    App_Run(std::chrono::microseconds{2000});
+}
@@ -0,0 +1,568 @@
+#include <print>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <cstdint>
+#include <algorithm>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+struct CURL_AsyncOptions
+{
+    // threads running completion callbacks; 0 runs them inline, in tick()
+    std::size_t callback_threads = 0;
+};
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create(const CURL_AsyncOptions& options = {});
+// runs callbacks already handed to the pool before returning
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout);
+// transfers not finished yet; callbacks queued on the pool are not counted
+std::size_t CURL_async_running(CURL_Async curl_async);
+
+// main async callback API; loop thread only (the one that created
+// `curl_async`), so with callback_threads > 0 a callback can't chain another
+// request directly. With callback_threads > 0, `callback` runs on any pool
+// thread, possibly concurrently with other callbacks
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+// same, but callbacks with the same `order_key` run one at a time,
+// in the order their transfers finished. Keys may be per-request: a key's
+// bookkeeping is dropped once its callbacks have all run
+void CURL_async_get_ordered(CURL_Async curl_async
+    , const std::string& url
+    , std::uint64_t order_key
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+using Pool_Job = std::function<void ()>;
+
+struct Pool_Worker
+{
+    // owner takes oldest (completion order), thieves take newest
+    std::mutex _mutex;
+    std::deque<Pool_Job> _jobs;
+    std::thread _thread;
+};
+
+struct Pool_ThreadPool
+{
+    explicit Pool_ThreadPool(std::size_t threads);
+    // runs everything queued, then joins
+    ~Pool_ThreadPool();
+    // no copy, no move
+    Pool_ThreadPool(const Pool_ThreadPool&) = delete;
+
+    // loop thread only
+    void post(Pool_Job job);
+    void loop(std::size_t index);
+    bool take(std::size_t index, Pool_Job& job);
+
+    std::vector<std::unique_ptr<Pool_Worker>> _workers;
+    // round-robin target of the next post()
+    std::size_t _next = 0;
+    // total jobs in all workers; changed under the owning worker's mutex
+    std::atomic<std::size_t> _queued{0};
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    bool _stop = false;
+};
+
+Pool_ThreadPool::Pool_ThreadPool(std::size_t threads)
+{
+    assert(threads > 0);
+    _workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        _workers.push_back(std::make_unique<Pool_Worker>());
+    }
+    // start only once all workers exist, thieves look at every one of them
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        _workers[i]->_thread = std::thread{[this, i]() { loop(i); }};
+    }
+}
+
+Pool_ThreadPool::~Pool_ThreadPool()
+{
+    {
+        std::lock_guard lock{_wake_mutex};
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (std::unique_ptr<Pool_Worker>& worker : _workers)
+    {
+        worker->_thread.join();
+    }
+    assert(_queued.load() == 0);
+}
+
+void Pool_ThreadPool::post(Pool_Job job)
+{
+    assert(job);
+    Pool_Worker& worker = *_workers[_next];
+    _next = (_next + 1) % _workers.size();
+    {
+        std::lock_guard lock{worker._mutex};
+        worker._jobs.push_back(std::move(job));
+        _queued.fetch_add(1);
+    }
+    {
+        // pairs with the predicate check in loop(), no lost wake-ups
+        std::lock_guard lock{_wake_mutex};
+    }
+    _wake.notify_one();
+}
+
+bool Pool_ThreadPool::take(std::size_t index, Pool_Job& job)
+{
+    {
+        Pool_Worker& own = *_workers[index];
+        std::lock_guard lock{own._mutex};
+        if (!own._jobs.empty())
+        {
+            job = std::move(own._jobs.front());
+            own._jobs.pop_front();
+            _queued.fetch_sub(1);
+            return true;
+        }
+    }
+    for (std::size_t i = 1; i < _workers.size(); ++i)
+    {
+        Pool_Worker& victim = *_workers[(index + i) % _workers.size()];
+        std::lock_guard lock{victim._mutex};
+        if (!victim._jobs.empty())
+        {
+            job = std::move(victim._jobs.back());
+            victim._jobs.pop_back();
+            _queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Pool_ThreadPool::loop(std::size_t index)
+{
+    while (true)
+    {
+        Pool_Job job;
+        if (take(index, job))
+        {
+            job();
+            continue;
+        }
+        std::unique_lock lock{_wake_mutex};
+        _wake.wait(lock, [this]()
+        {
+            return _stop || (_queued.load() > 0);
+        });
+        if (_stop && (_queued.load() == 0))
+        {
+            return;
+        }
+    }
+}
+
+// serializes jobs with the same key on top of the pool; at most one
+// drain() of a strand is queued or running at any time
+struct Pool_Strand
+{
+    std::mutex _mutex;
+    std::deque<Pool_Job> _jobs;
+    bool _scheduled = false;
+
+    void drain();
+};
+
+void Pool_Strand::drain()
+{
+    while (true)
+    {
+        Pool_Job job;
+        {
+            std::lock_guard lock{_mutex};
+            if (_jobs.empty())
+            {
+                _scheduled = false;
+                return;
+            }
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+        job();
+    }
+}
+
+struct CURL_AsyncScheduler
+{
+    explicit CURL_AsyncScheduler(const CURL_AsyncOptions& options);
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+    // runs `job` inline or on the pool; loop thread only
+    void dispatch(const std::uint64_t* order_key, Pool_Job job);
+    // drops strands reported idle by the pool, unless reused since
+    void erase_idle_strands();
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+    const std::thread::id _loop_thread = std::this_thread::get_id();
+    // declared before _pool to outlive its threads
+    std::unordered_map<std::uint64_t, std::unique_ptr<Pool_Strand>> _strands;
+    // keys whose drain() found nothing left, pushed from pool threads
+    std::mutex _idle_mutex;
+    std::vector<std::uint64_t> _idle_strands;
+    // swapped with _idle_strands under the lock, processed outside
+    std::vector<std::uint64_t> _idle_to_erase;
+    std::unique_ptr<Pool_ThreadPool> _pool;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler(const CURL_AsyncOptions& options)
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+    if (options.callback_threads > 0)
+    {
+        _pool = std::make_unique<Pool_ThreadPool>(options.callback_threads);
+    }
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    _pool.reset();
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    erase_idle_strands();
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+void CURL_AsyncScheduler::dispatch(const std::uint64_t* order_key, Pool_Job job)
+{
+    if (!_pool)
+    {
+        job();
+        return;
+    }
+    if (!order_key)
+    {
+        _pool->post(std::move(job));
+        return;
+    }
+    std::unique_ptr<Pool_Strand>& strand = _strands[*order_key];
+    if (!strand)
+    {
+        strand = std::make_unique<Pool_Strand>();
+    }
+    bool schedule = false;
+    {
+        std::lock_guard lock{strand->_mutex};
+        strand->_jobs.push_back(std::move(job));
+        schedule = !std::exchange(strand->_scheduled, true);
+    }
+    if (schedule)
+    {
+        _pool->post([this, s = strand.get(), key = *order_key]()
+        {
+            s->drain();
+            // `s` may be gone from here on
+            std::lock_guard lock{_idle_mutex};
+            _idle_strands.push_back(key);
+        });
+    }
+}
+
+void CURL_AsyncScheduler::erase_idle_strands()
+{
+    {
+        std::lock_guard lock{_idle_mutex};
+        _idle_to_erase.swap(_idle_strands);
+    }
+    for (std::uint64_t key : _idle_to_erase)
+    {
+        auto it = _strands.find(key);
+        if (it == _strands.end())
+        {   // reported twice
+            continue;
+        }
+        // only this thread queues jobs: not scheduled means empty for good
+        bool idle = false;
+        {
+            std::lock_guard lock{it->second->_mutex};
+            idle = !it->second->_scheduled;
+        }
+        if (idle)
+        {
+            (void)_strands.erase(it);
+        }
+    }
+    _idle_to_erase.clear();
+}
+
+CURL_Async CURL_async_create(const CURL_AsyncOptions& options /*= {}*/)
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler(options);
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout)
+{
+    const CURLMcode status = curl_multi_poll(CURL_scheduler(curl_async)._multi_curl
+        , nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    assert(status == CURLM_OK);
+}
+
+std::size_t CURL_async_running(CURL_Async curl_async)
+{
+    return CURL_scheduler(curl_async)._curl_to_callback.size();
+}
+
+static void CURL_async_get_impl(CURL_Async curl_async
+    , const std::string& url
+    , const std::uint64_t* order_key
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // _multi_curl and _curl_to_callback are not synchronized
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(curl_async);
+    assert(std::this_thread::get_id() == scheduler._loop_thread);
+
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to separate std::string
+    std::string* state = new std::string{};
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop; the easy handle is
+    //    released on the loop thread, only the user callback is offloaded
+    const bool ordered = (order_key != nullptr);
+    const std::uint64_t key = ordered ? *order_key : 0;
+    scheduler.add_request(curl_easy
+        , [&scheduler, ordered, key, state, user_data, callback](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(*state);
+        delete state;
+        scheduler.dispatch(ordered ? &key : nullptr
+            , [user_data, callback, data_ = std::move(data)]() mutable
+        {
+            callback(user_data, std::move(data_));
+        });
+    });
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    CURL_async_get_impl(curl_async, url, nullptr, user_data, callback);
+}
+
+void CURL_async_get_ordered(CURL_Async curl_async
+    , const std::string& url
+    , std::uint64_t order_key
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    CURL_async_get_impl(curl_async, url, &order_key, user_data, callback);
+}
+
+using App_Clock = std::chrono::steady_clock;
+
+static void App_HeavyWork(std::chrono::microseconds duration)
+{
+    const App_Clock::time_point end = App_Clock::now() + duration;
+    while (App_Clock::now() < end)
+    {
+    }
+}
+
+static constexpr std::size_t kApp_Keys = 4;
+
+struct App_Stats
+{
+    std::atomic<std::size_t> responses{0};
+    // set while a callback for the key runs, to catch overlapping ones
+    std::atomic<bool> key_busy[kApp_Keys]{};
+    std::atomic<std::size_t> overlaps{0};
+};
+
+struct App_Request
+{
+    App_Stats* stats = nullptr;
+    std::size_t key = 0;
+};
+
+static void App_OnResponse(void* user_data, std::string response)
+{
+    App_Request& request = *static_cast<App_Request*>(user_data);
+    App_Stats& stats = *request.stats;
+    assert(!response.empty());
+    if (stats.key_busy[request.key].exchange(true))
+    {
+        stats.overlaps.fetch_add(1);
+    }
+    // heavy parsing
+    App_HeavyWork(std::chrono::microseconds{1000});
+    stats.key_busy[request.key].store(false);
+    stats.responses.fetch_add(1);
+}
+
+static void App_Run(std::size_t callback_threads, bool ordered)
+{
+    const std::size_t kRequests = 200;
+    CURL_Async curl_async = CURL_async_create(CURL_AsyncOptions{callback_threads});
+    App_Stats stats;
+    std::vector<App_Request> requests(kRequests);
+    const App_Clock::time_point start = App_Clock::now();
+    for (std::size_t i = 0; i < kRequests; ++i)
+    {
+        requests[i] = App_Request{&stats, i % kApp_Keys};
+        if (ordered)
+        {
+            CURL_async_get_ordered(curl_async, "localhost:5001/file1.txt"
+                , requests[i].key, &requests[i], &App_OnResponse);
+        }
+        else
+        {
+            CURL_async_get(curl_async, "localhost:5001/file1.txt"
+                , &requests[i], &App_OnResponse);
+        }
+    }
+
+    App_Clock::duration transfers_done{};
+    while (stats.responses.load() < kRequests)
+    {
+        CURL_async_tick(curl_async);
+        if ((transfers_done == App_Clock::duration{}) && (CURL_async_running(curl_async) == 0))
+        {
+            transfers_done = App_Clock::now() - start;
+        }
+        CURL_async_wait(curl_async, std::chrono::milliseconds{1});
+    }
+    const App_Clock::duration callbacks_done = App_Clock::now() - start;
+    CURL_async_destroy(curl_async);
+    if (ordered)
+    {
+        assert(stats.overlaps.load() == 0);
+    }
+
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    std::println("threads {} {:>9}: transfers done in {:>3} ms, callbacks done in {:>3} ms, same-key overlaps {}"
+        , callback_threads, ordered ? "ordered" : "unordered"
+        , duration_cast<milliseconds>(transfers_done).count()
+        , duration_cast<milliseconds>(callbacks_done).count()
+        , stats.overlaps.load());
+}
+
+int main()
+{
+    const std::size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    App_Run(0, false);
+    App_Run(threads, false);
+    App_Run(threads, true);
+}
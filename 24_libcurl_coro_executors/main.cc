@@ -0,0 +1,670 @@
+#include <print>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <optional>
+#include <coroutine>
+#include <chrono>
+#include <algorithm>
+#include <utility>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout);
+// thread-safe: runs `fn` on the loop thread, from the next tick()
+void CURL_async_post(CURL_Async curl_async, std::function<void ()> fn);
+
+// main async callback API; loop thread only
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+    void post(std::function<void ()> fn);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+    // filled from any thread, drained by tick()
+    std::mutex _posted_mutex;
+    std::vector<std::function<void ()>> _posted;
+    std::vector<std::function<void ()>> _running;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    assert(_posted.empty());
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    // 1. work posted from other threads (new requests, resumptions)
+    {
+        std::lock_guard lock{_posted_mutex};
+        _running.swap(_posted);
+    }
+    for (std::function<void ()>& fn : _running)
+    {
+        fn();
+    }
+    _running.clear();
+
+    // 2. libcurl bookkeeping
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+void CURL_AsyncScheduler::post(std::function<void ()> fn)
+{
+    assert(fn);
+    {
+        std::lock_guard lock{_posted_mutex};
+        _posted.push_back(std::move(fn));
+    }
+    // thread-safe: interrupts curl_multi_poll() in CURL_async_wait()
+    const CURLMcode status = curl_multi_wakeup(_multi_curl);
+    assert(status == CURLM_OK);
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout)
+{
+    const CURLMcode status = curl_multi_poll(CURL_scheduler(curl_async)._multi_curl
+        , nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    assert(status == CURLM_OK);
+}
+
+void CURL_async_post(CURL_Async curl_async, std::function<void ()> fn)
+{
+    CURL_scheduler(curl_async).post(std::move(fn));
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to separate std::string
+    std::string* state = new std::string{};
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    CURL_scheduler(curl_async).add_request(curl_easy
+        , [state, user_data, callback](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(*state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+}
+
+// where a suspended coroutine continues; default-constructed is inline,
+// i.e. on whatever thread completes the awaited operation
+struct Co_Executor
+{
+    void* _context = nullptr;
+    void (*_post)(void* context, std::coroutine_handle<> coro) = nullptr;
+
+    void post(std::coroutine_handle<> coro) const
+    {
+        assert(coro);
+        if (_post)
+        {
+            _post(_context, coro);
+        }
+        else
+        {
+            coro.resume();
+        }
+    }
+};
+
+Co_Executor Co_inline_executor()
+{
+    return Co_Executor{};
+}
+
+// resumes from the loop thread's tick()
+Co_Executor CURL_async_executor(CURL_Async curl_async)
+{
+    return Co_Executor{curl_async, [](void* context, std::coroutine_handle<> coro)
+    {
+        CURL_async_post(context, [coro]() { coro.resume(); });
+    }};
+}
+
+using Pool_Job = std::coroutine_handle<>;
+
+struct Pool_Worker
+{
+    // owner takes oldest, thieves take newest
+    std::mutex _mutex;
+    std::deque<Pool_Job> _jobs;
+    std::thread _thread;
+};
+
+// work-stealing pool resuming coroutines
+struct Pool_ThreadPool
+{
+    explicit Pool_ThreadPool(std::size_t threads);
+    // runs everything queued, then joins
+    ~Pool_ThreadPool();
+    // no copy, no move
+    Pool_ThreadPool(const Pool_ThreadPool&) = delete;
+
+    // thread-safe
+    void post(Pool_Job job);
+    void loop(std::size_t index);
+    bool take(std::size_t index, Pool_Job& job);
+
+    std::vector<std::unique_ptr<Pool_Worker>> _workers;
+    // round-robin target of the next post()
+    std::atomic<std::size_t> _next{0};
+    // total jobs in all workers; changed under the owning worker's mutex
+    std::atomic<std::size_t> _queued{0};
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    bool _stop = false;
+};
+
+Pool_ThreadPool::Pool_ThreadPool(std::size_t threads)
+{
+    assert(threads > 0);
+    _workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        _workers.push_back(std::make_unique<Pool_Worker>());
+    }
+    // start only once all workers exist, thieves look at every one of them
+    for (std::size_t i = 0; i < threads; ++i)
+    {
+        _workers[i]->_thread = std::thread{[this, i]() { loop(i); }};
+    }
+}
+
+Pool_ThreadPool::~Pool_ThreadPool()
+{
+    {
+        std::lock_guard lock{_wake_mutex};
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (std::unique_ptr<Pool_Worker>& worker : _workers)
+    {
+        worker->_thread.join();
+    }
+    assert(_queued.load() == 0);
+}
+
+void Pool_ThreadPool::post(Pool_Job job)
+{
+    assert(job);
+    Pool_Worker& worker = *_workers[_next.fetch_add(1) % _workers.size()];
+    {
+        std::lock_guard lock{worker._mutex};
+        worker._jobs.push_back(job);
+        _queued.fetch_add(1);
+    }
+    {
+        // pairs with the predicate check in loop(), no lost wake-ups
+        std::lock_guard lock{_wake_mutex};
+    }
+    _wake.notify_one();
+}
+
+bool Pool_ThreadPool::take(std::size_t index, Pool_Job& job)
+{
+    {
+        Pool_Worker& own = *_workers[index];
+        std::lock_guard lock{own._mutex};
+        if (!own._jobs.empty())
+        {
+            job = own._jobs.front();
+            own._jobs.pop_front();
+            _queued.fetch_sub(1);
+            return true;
+        }
+    }
+    for (std::size_t i = 1; i < _workers.size(); ++i)
+    {
+        Pool_Worker& victim = *_workers[(index + i) % _workers.size()];
+        std::lock_guard lock{victim._mutex};
+        if (!victim._jobs.empty())
+        {
+            job = victim._jobs.back();
+            victim._jobs.pop_back();
+            _queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Pool_ThreadPool::loop(std::size_t index)
+{
+    while (true)
+    {
+        Pool_Job job;
+        if (take(index, job))
+        {
+            job.resume();
+            continue;
+        }
+        std::unique_lock lock{_wake_mutex};
+        _wake.wait(lock, [this]()
+        {
+            return _stop || (_queued.load() > 0);
+        });
+        if (_stop && (_queued.load() == 0))
+        {
+            return;
+        }
+    }
+}
+
+Co_Executor Pool_executor(Pool_ThreadPool& pool)
+{
+    return Co_Executor{&pool, [](void* context, std::coroutine_handle<> coro)
+    {
+        static_cast<Pool_ThreadPool*>(context)->post(coro);
+    }};
+}
+
+struct Co_Task
+{
+    struct promise_type;
+    using co_handle = std::coroutine_handle<promise_type>;
+
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(co_handle coro) noexcept
+        {
+            // frame is suspended now: safe for another thread to destroy it
+            coro.promise()._done.store(true, std::memory_order_release);
+        }
+
+        void await_resume() noexcept
+        {
+        }
+    };
+
+    struct promise_type
+    {
+        Co_Task get_return_object()
+        {
+            return Co_Task{co_handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()
+        {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+            // yeah, we return void. Nothing to do
+        }
+
+        void unhandled_exception()
+        {
+            // crash, no exceptions handling
+            assert(false);
+        }
+
+        // default for awaiters that don't pick an executor themselves
+        Co_Executor _executor;
+        // may be resumed on another thread than the one polling
+        std::atomic<bool> _done{false};
+    };
+
+    Co_Task(co_handle coro)
+        : _coro{coro} {}
+    Co_Task(Co_Task&& rhs) noexcept
+        : _coro{std::exchange(rhs._coro, {})} { }
+    Co_Task(const Co_Task&) = delete;
+    ~Co_Task() noexcept
+    {
+        if (_coro)
+        {
+            _coro.destroy();
+        }
+    }
+
+    // before the first resume()
+    void resume_on(Co_Executor executor)
+    {
+        assert(_coro);
+        _coro.promise()._executor = executor;
+    }
+
+    void resume()
+    {
+        assert(_coro);
+        assert(!_coro.done());
+        _coro.resume();
+    }
+
+    bool is_in_progress() const
+    {
+        assert(_coro);
+        return !_coro.promise()._done.load(std::memory_order_acquire);
+    }
+
+    co_handle _coro;
+};
+
+// executor for the awaiter: explicit one, else the awaiting task's, else inline
+template<typename Promise>
+static Co_Executor Co_resume_executor(const std::optional<Co_Executor>& explicit_executor
+    , std::coroutine_handle<Promise> coro)
+{
+    if (explicit_executor)
+    {
+        return *explicit_executor;
+    }
+    if constexpr (requires { coro.promise()._executor; })
+    {
+        return coro.promise()._executor;
+    }
+    return Co_inline_executor();
+}
+
+struct Co_CurlAsync
+{
+    CURL_Async _curl_async{};
+    std::string _url;
+    std::optional<Co_Executor> _resume_on;
+    Co_Executor _executor;
+    std::coroutine_handle<> _coro;
+    std::string _response;
+
+    bool await_ready()
+    { // 1. CURL_async_get() is not yet started, force coroutine suspend:
+        return false;
+    }
+
+    template<typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> coro)
+    { // 2. remember coroutine handle, start request on the loop thread:
+        _coro = coro;
+        _executor = Co_resume_executor(_resume_on, coro);
+
+        // may be running on a pool thread; last use of `this` here
+        CURL_async_post(_curl_async, [this]()
+        {
+            CURL_async_get(_curl_async, _url, this
+                , [](void* user_data, std::string response)
+            {
+                Co_CurlAsync& self = *static_cast<Co_CurlAsync*>(user_data);
+                self._response = std::move(response);
+                self._executor.post(self._coro);
+            });
+        });
+    }
+
+    std::string await_resume()
+    { // 3. after resume, return response:
+        return std::move(_response);
+    }
+};
+
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url
+    , std::optional<Co_Executor> resume_on = std::nullopt)
+{
+    Co_CurlAsync awaiter;
+    awaiter._curl_async = curl_async;
+    awaiter._url = url;
+    awaiter._resume_on = resume_on;
+    return awaiter;
+}
+
+// `co_await schedule_on(executor)`: continue on `executor`. One-off hop,
+// the task's resume_on() executor stays as it was
+struct Co_ScheduleOn
+{
+    Co_Executor _executor;
+
+    bool await_ready()
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    {
+        _executor.post(coro);
+    }
+
+    void await_resume()
+    {
+    }
+};
+
+Co_ScheduleOn schedule_on(Co_Executor executor)
+{
+    return Co_ScheduleOn{executor};
+}
+
+using App_Clock = std::chrono::steady_clock;
+
+static void App_HeavyWork(std::chrono::microseconds duration)
+{
+    const App_Clock::time_point end = App_Clock::now() + duration;
+    while (App_Clock::now() < end)
+    {
+    }
+}
+
+enum class App_Mode
+{
+    Inline,
+    ResumeOnPool,
+    ScheduleOnPool,
+};
+
+struct App_State
+{
+    std::thread::id loop_thread;
+    // touched from the loop thread only
+    std::size_t bytes = 0;
+    std::atomic<std::size_t> parsed_on_loop{0};
+};
+
+static Co_Task coro_worker(CURL_Async curl_async, Pool_ThreadPool& pool
+    , App_Mode mode, App_State& app)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        const std::string response = co_await CURL_await_get(
+            curl_async, "localhost:5001/file1.txt");
+        if (mode == App_Mode::ScheduleOnPool)
+        {
+            co_await schedule_on(Pool_executor(pool));
+        }
+        // CPU-bound post-processing
+        App_HeavyWork(std::chrono::microseconds{500});
+        if (std::this_thread::get_id() == app.loop_thread)
+        {
+            app.parsed_on_loop.fetch_add(1);
+        }
+        // back to the loop thread for single-threaded state
+        co_await schedule_on(CURL_async_executor(curl_async));
+        assert(std::this_thread::get_id() == app.loop_thread);
+        app.bytes += response.size();
+    }
+    co_return;
+}
+
+static void App_Run(App_Mode mode)
+{
+    const std::size_t threads = std::max(2u, std::thread::hardware_concurrency());
+    Pool_ThreadPool pool{threads};
+    CURL_Async curl_async = CURL_async_create();
+    App_State app;
+    app.loop_thread = std::this_thread::get_id();
+    std::vector<Co_Task> tasks;
+    for (int i = 0; i < 100; ++i)
+    {
+        tasks.push_back(coro_worker(curl_async, pool, mode, app));
+        if (mode == App_Mode::ResumeOnPool)
+        {
+            tasks.back().resume_on(Pool_executor(pool));
+        }
+        tasks.back().resume();
+    }
+
+    App_Clock::duration max_tick{};
+    auto in_progress = [&tasks]()
+    {
+        return std::any_of(tasks.begin(), tasks.end(), [](const Co_Task& task)
+        {
+            return task.is_in_progress();
+        });
+    };
+    while (in_progress())
+    {
+        const App_Clock::time_point start = App_Clock::now();
+        CURL_async_tick(curl_async);
+        max_tick = std::max(max_tick, App_Clock::now() - start);
+        CURL_async_wait(curl_async, std::chrono::milliseconds{1});
+    }
+    tasks.clear();
+    CURL_async_destroy(curl_async);
+
+    const char* names[] = {"inline", "resume_on(pool)", "schedule_on(pool)"};
+    std::println("{:>17}: {} bytes, parsed on loop thread {}, max tick {} us"
+        , names[static_cast<int>(mode)], app.bytes, app.parsed_on_loop.load()
+        , std::chrono::duration_cast<std::chrono::microseconds>(max_tick).count());
+}
+
+int main()
+{
+    App_Run(App_Mode::Inline);
+    App_Run(App_Mode::ResumeOnPool);
+    App_Run(App_Mode::ScheduleOnPool);
+}
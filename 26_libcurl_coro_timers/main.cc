@@ -0,0 +1,729 @@
+#include <print>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <optional>
+#include <coroutine>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <type_traits>
+#include <concepts>
+#include <utility>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+using CURL_Clock = std::chrono::steady_clock;
+
+// caller-owned, intrusive: lives as long as it's started
+struct CURL_Timer
+{
+    CURL_Clock::time_point deadline;
+    void* user_data = nullptr;
+    void (*on_expire)(void* user_data) = nullptr;
+
+    // internal, position in the scheduler's heap
+    static constexpr std::size_t kNotStarted = std::size_t(-1);
+    std::size_t _heap_index = kNotStarted;
+};
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+// also fires expired timers
+void CURL_async_tick(CURL_Async curl_async);
+// sleeps until socket activity, a libcurl timeout, the next CURL_Timer
+// deadline or `timeout`, whichever comes first
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout);
+// `on_expire` is called from a later tick(), once
+void CURL_async_timer_start(CURL_Async curl_async, CURL_Timer& timer);
+// no-op if already expired
+void CURL_async_timer_cancel(CURL_Async curl_async, CURL_Timer& timer);
+
+// main async callback API; returned id can be used to cancel the request,
+// callback is not called then
+using CURL_AsyncRequestId = void*;
+CURL_AsyncRequestId CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+void CURL_async_cancel(CURL_Async curl_async, CURL_AsyncRequestId request);
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+// binary min-heap of started timers by deadline; timers know their index,
+// so cancel is O(log n) as well
+struct CURL_TimerHeap
+{
+    bool empty() const
+    {
+        return _timers.empty();
+    }
+
+    CURL_Timer* top() const
+    {
+        assert(!_timers.empty());
+        return _timers.front();
+    }
+
+    void push(CURL_Timer& timer);
+    void remove(CURL_Timer& timer);
+    void sift_up(std::size_t index);
+    void sift_down(std::size_t index);
+    void place(std::size_t index, CURL_Timer* timer);
+
+    std::vector<CURL_Timer*> _timers;
+};
+
+void CURL_TimerHeap::place(std::size_t index, CURL_Timer* timer)
+{
+    _timers[index] = timer;
+    timer->_heap_index = index;
+}
+
+void CURL_TimerHeap::sift_up(std::size_t index)
+{
+    CURL_Timer* timer = _timers[index];
+    while (index > 0)
+    {
+        const std::size_t parent = (index - 1) / 2;
+        if (_timers[parent]->deadline <= timer->deadline)
+        {
+            break;
+        }
+        place(index, _timers[parent]);
+        index = parent;
+    }
+    place(index, timer);
+}
+
+void CURL_TimerHeap::sift_down(std::size_t index)
+{
+    CURL_Timer* timer = _timers[index];
+    const std::size_t size = _timers.size();
+    while (true)
+    {
+        std::size_t child = 2 * index + 1;
+        if (child >= size)
+        {
+            break;
+        }
+        if ((child + 1 < size) && (_timers[child + 1]->deadline < _timers[child]->deadline))
+        {
+            ++child;
+        }
+        if (timer->deadline <= _timers[child]->deadline)
+        {
+            break;
+        }
+        place(index, _timers[child]);
+        index = child;
+    }
+    place(index, timer);
+}
+
+void CURL_TimerHeap::push(CURL_Timer& timer)
+{
+    assert(timer._heap_index == CURL_Timer::kNotStarted);
+    _timers.push_back(&timer);
+    sift_up(_timers.size() - 1);
+}
+
+void CURL_TimerHeap::remove(CURL_Timer& timer)
+{
+    const std::size_t index = timer._heap_index;
+    assert(index < _timers.size());
+    assert(_timers[index] == &timer);
+    CURL_Timer* last = _timers.back();
+    _timers.pop_back();
+    timer._heap_index = CURL_Timer::kNotStarted;
+    if (last != &timer)
+    {
+        place(index, last);
+        sift_down(index);
+        sift_up(last->_heap_index);
+    }
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    // CURLE_ABORTED_BY_CALLBACK when cancelled
+    using Callback = std::function<void (CURL* curl_easy, CURLcode result)>;
+
+    void tick();
+    void fire_timers();
+    void add_request(CURL* curl_easy, Callback on_finish);
+    void cancel_request(CURL* curl_easy);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+    CURL_TimerHeap _timers;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    assert(_curl_to_callback.empty());
+    assert(_timers.empty());
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        const CURLcode result = m->data.result;
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy, result);
+    }
+    fire_timers();
+}
+
+void CURL_AsyncScheduler::fire_timers()
+{
+    // timers started by on_expire() for "now" wait for the next tick
+    const CURL_Clock::time_point now = CURL_Clock::now();
+    while (!_timers.empty() && (_timers.top()->deadline <= now))
+    {
+        CURL_Timer& timer = *_timers.top();
+        _timers.remove(timer);
+        timer.on_expire(timer.user_data);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+void CURL_AsyncScheduler::cancel_request(CURL* curl_easy)
+{
+    auto it = _curl_to_callback.find(curl_easy);
+    assert(it != _curl_to_callback.end());
+    const CURLMcode status = curl_multi_remove_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    Callback callback = std::move(it->second);
+    (void)_curl_to_callback.erase(it);
+    callback(curl_easy, CURLE_ABORTED_BY_CALLBACK);
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout)
+{
+    CURL_AsyncScheduler& scheduler = CURL_scheduler(curl_async);
+    if (!scheduler._timers.empty())
+    {
+        // round up: waking before the deadline would just poll again
+        const auto left = std::chrono::ceil<std::chrono::milliseconds>(
+            scheduler._timers.top()->deadline - CURL_Clock::now());
+        timeout = std::clamp(left, std::chrono::milliseconds{0}, timeout);
+    }
+    // curl_multi_poll() itself caps the wait by libcurl's own timers
+    const CURLMcode status = curl_multi_poll(scheduler._multi_curl
+        , nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    assert(status == CURLM_OK);
+}
+
+void CURL_async_timer_start(CURL_Async curl_async, CURL_Timer& timer)
+{
+    assert(timer.on_expire);
+    CURL_scheduler(curl_async)._timers.push(timer);
+}
+
+void CURL_async_timer_cancel(CURL_Async curl_async, CURL_Timer& timer)
+{
+    if (timer._heap_index != CURL_Timer::kNotStarted)
+    {
+        CURL_scheduler(curl_async)._timers.remove(timer);
+    }
+}
+
+CURL_AsyncRequestId CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to separate std::string
+    std::string* state = new std::string{};
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    CURL_scheduler(curl_async).add_request(curl_easy
+        , [state, user_data, callback](CURL* curl_easy_, CURLcode result)
+    {
+        if (result == CURLE_ABORTED_BY_CALLBACK)
+        {   // cancelled: clean up, nobody to notify
+            curl_easy_cleanup(curl_easy_);
+            delete state;
+            return;
+        }
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(*state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+    return curl_easy;
+}
+
+void CURL_async_cancel(CURL_Async curl_async, CURL_AsyncRequestId request)
+{
+    assert(request);
+    CURL_scheduler(curl_async).cancel_request(static_cast<CURL*>(request));
+}
+
+// co_return value storage, void has none
+template<typename T>
+struct Co_TaskResult
+{
+    void return_value(T value)
+    {
+        _result.emplace(std::move(value));
+    }
+
+    T take_result()
+    {
+        assert(_result);
+        return std::move(*_result);
+    }
+
+    std::optional<T> _result;
+};
+
+template<>
+struct Co_TaskResult<void>
+{
+    void return_void()
+    {
+        // yeah, we return void. Nothing to do
+    }
+
+    void take_result()
+    {
+    }
+};
+
+template<typename T = void>
+struct Co_Task
+{
+    struct promise_type;
+    using co_handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type : Co_TaskResult<T>
+    {
+        Co_Task get_return_object()
+        {
+            return Co_Task{co_handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void unhandled_exception()
+        {
+            // crash, no exceptions handling
+            assert(false);
+        }
+    };
+
+    Co_Task(co_handle coro)
+        : _coro{coro} {}
+    Co_Task(Co_Task&& rhs) noexcept
+        : _coro{std::exchange(rhs._coro, {})} { }
+    Co_Task(const Co_Task&) = delete;
+    ~Co_Task() noexcept
+    {
+        if (_coro)
+        {
+            _coro.destroy();
+        }
+    }
+
+    void resume()
+    {
+        assert(_coro);
+        assert(!_coro.done());
+        _coro.resume();
+    }
+
+    bool is_in_progress() const
+    {
+        assert(_coro);
+        return !_coro.done();
+    }
+
+    T take_result()
+    {
+        assert(_coro);
+        assert(_coro.done());
+        return _coro.promise().take_result();
+    }
+
+    co_handle _coro;
+};
+
+// runs `task` to completion on this thread and returns its co_return value
+template<typename T>
+T sync_wait(CURL_Async curl_async, Co_Task<T> task)
+{
+    task.resume();
+    while (task.is_in_progress())
+    {
+        CURL_async_tick(curl_async);
+        if (!task.is_in_progress())
+        {
+            break;
+        }
+        // upper bound only, sockets and timers wake earlier
+        CURL_async_wait(curl_async, std::chrono::milliseconds{1000});
+    }
+    return task.take_result();
+}
+
+// awaiters below can be cancelled while suspended, see with_timeout();
+// cancel() means the coroutine is not resumed by the awaiter anymore
+struct Co_CurlAsync
+{
+    CURL_Async _curl_async{};
+    std::string _url;
+    std::coroutine_handle<> _coro;
+    CURL_AsyncRequestId _request = nullptr;
+    std::string _response;
+
+    bool await_ready()
+    { // 1. CURL_async_get() is not yet started, force coroutine suspend:
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    { // 2. remember coroutine handle, start request, resume on finish:
+        _coro = coro;
+
+        _request = CURL_async_get(_curl_async, _url, this
+            , [](void* user_data, std::string response)
+        {
+            Co_CurlAsync& self = *static_cast<Co_CurlAsync*>(user_data);
+            self._request = nullptr;
+            self._response = std::move(response);
+            self._coro.resume();
+        });
+    }
+
+    std::string await_resume()
+    { // 3. after resume, return response:
+        return std::move(_response);
+    }
+
+    CURL_Async curl_async() const
+    {
+        return _curl_async;
+    }
+
+    void cancel()
+    {
+        assert(_request);
+        CURL_async_cancel(_curl_async, std::exchange(_request, nullptr));
+    }
+};
+
+Co_CurlAsync CURL_await_get(CURL_Async curl_async, const std::string& url)
+{
+    Co_CurlAsync awaiter;
+    awaiter._curl_async = curl_async;
+    awaiter._url = url;
+    return awaiter;
+}
+
+// `co_await sleep_for(curl_async, 50ms)`; the timer lives in the coroutine frame
+struct Co_Sleep
+{
+    CURL_Async _curl_async{};
+    CURL_Clock::duration _duration{};
+    CURL_Timer _timer;
+
+    bool await_ready()
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    {
+        _timer.deadline = CURL_Clock::now() + _duration;
+        _timer.user_data = coro.address();
+        _timer.on_expire = [](void* user_data)
+        {
+            std::coroutine_handle<>::from_address(user_data).resume();
+        };
+        CURL_async_timer_start(_curl_async, _timer);
+    }
+
+    void await_resume()
+    {
+    }
+
+    CURL_Async curl_async() const
+    {
+        return _curl_async;
+    }
+
+    void cancel()
+    {
+        CURL_async_timer_cancel(_curl_async, _timer);
+    }
+};
+
+Co_Sleep sleep_for(CURL_Async curl_async, CURL_Clock::duration duration)
+{
+    Co_Sleep awaiter;
+    awaiter._curl_async = curl_async;
+    awaiter._duration = duration;
+    return awaiter;
+}
+
+template<typename Awaiter>
+concept Co_CancellableAwaiter = requires(Awaiter& awaiter)
+{
+    { awaiter.curl_async() } -> std::same_as<CURL_Async>;
+    awaiter.cancel();
+};
+
+// `co_await with_timeout(awaiter, 2s)`: std::nullopt (or false, for void
+// awaiters) when `timeout` expires first; the inner operation is cancelled
+template<Co_CancellableAwaiter Awaiter>
+struct Co_WithTimeout
+{
+    using InnerResult = decltype(std::declval<Awaiter&>().await_resume());
+    using Result = std::conditional_t<std::is_void_v<InnerResult>
+        , bool, std::optional<InnerResult>>;
+
+    Awaiter _inner;
+    CURL_Clock::duration _timeout{};
+    CURL_Timer _timer{};
+    std::coroutine_handle<> _coro{};
+    bool _timed_out = false;
+
+    bool await_ready()
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coro)
+    {
+        _coro = coro;
+        _timer.deadline = CURL_Clock::now() + _timeout;
+        _timer.user_data = this;
+        _timer.on_expire = [](void* user_data)
+        {
+            Co_WithTimeout& self = *static_cast<Co_WithTimeout*>(user_data);
+            self._timed_out = true;
+            self._inner.cancel();
+            self._coro.resume();
+        };
+        CURL_async_timer_start(_inner.curl_async(), _timer);
+        // inner awaiter resumes `coro` directly when it wins
+        _inner.await_suspend(coro);
+    }
+
+    Result await_resume()
+    {
+        if (_timed_out)
+        {
+            return Result{};
+        }
+        CURL_async_timer_cancel(_inner.curl_async(), _timer);
+        if constexpr (std::is_void_v<InnerResult>)
+        {
+            _inner.await_resume();
+            return true;
+        }
+        else
+        {
+            return Result{_inner.await_resume()};
+        }
+    }
+};
+
+template<Co_CancellableAwaiter Awaiter>
+Co_WithTimeout<Awaiter> with_timeout(Awaiter awaiter, CURL_Clock::duration timeout)
+{
+    return Co_WithTimeout<Awaiter>{std::move(awaiter), timeout};
+}
+
+// periodic polling, no extra thread
+static Co_Task<std::size_t> coro_poll(CURL_Async curl_async, int count)
+{
+    std::size_t bytes = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const std::string response = co_await CURL_await_get(
+            curl_async, "localhost:5001/file1.txt");
+        bytes += response.size();
+        co_await sleep_for(curl_async, std::chrono::milliseconds{20});
+    }
+    co_return bytes;
+}
+
+static Co_Task<> coro_timeouts(CURL_Async curl_async)
+{
+    const std::optional<std::string> response = co_await with_timeout(
+        CURL_await_get(curl_async, "localhost:5001/file1.txt"), std::chrono::seconds{2});
+    assert(response);
+    std::println("with_timeout(get, 2s): '{}'", *response);
+
+    const bool slept = co_await with_timeout(
+        sleep_for(curl_async, std::chrono::seconds{1}), std::chrono::milliseconds{10});
+    assert(!slept);
+    std::println("with_timeout(sleep_for(1s), 10ms): timed out");
+}
+
+static Co_Task<> coro_sleeper(CURL_Async curl_async, CURL_Clock::time_point deadline
+    , std::chrono::microseconds& max_late, std::size_t& done)
+{
+    co_await sleep_for(curl_async, deadline - CURL_Clock::now());
+    const auto late = std::chrono::duration_cast<std::chrono::microseconds>(CURL_Clock::now() - deadline);
+    max_late = std::max(max_late, late);
+    ++done;
+}
+
+static void App_ManyTimers(CURL_Async curl_async, std::size_t count)
+{
+    std::mt19937 random{42};
+    // deadlines are relative to one `start`, so lateness includes
+    // any time spent starting the coroutines; 100ms covers that
+    std::uniform_int_distribution<int> delay_ms{100, 600};
+    std::chrono::microseconds max_late{0};
+    std::size_t done = 0;
+    std::size_t ticks = 0;
+    const CURL_Clock::time_point start = CURL_Clock::now();
+    std::vector<Co_Task<>> tasks;
+    tasks.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        tasks.push_back(coro_sleeper(curl_async
+            , start + std::chrono::milliseconds{delay_ms(random)}, max_late, done));
+        tasks.back().resume();
+    }
+    while (done < count)
+    {
+        CURL_async_tick(curl_async);
+        ++ticks;
+        if (done == count)
+        {
+            break;
+        }
+        CURL_async_wait(curl_async, std::chrono::milliseconds{1000});
+    }
+    std::println("{} timers: {} ms, {} ticks, max lateness {} us"
+        , count
+        , std::chrono::duration_cast<std::chrono::milliseconds>(CURL_Clock::now() - start).count()
+        , ticks, max_late.count());
+}
+
+int main()
+{
+    CURL_Async curl_async = CURL_async_create();
+
+    const CURL_Clock::time_point start = CURL_Clock::now();
+    const std::size_t bytes = sync_wait(curl_async, coro_poll(curl_async, 5));
+    std::println("polled {} bytes in {} ms", bytes
+        , std::chrono::duration_cast<std::chrono::milliseconds>(CURL_Clock::now() - start).count());
+
+    sync_wait(curl_async, coro_timeouts(curl_async));
+    App_ManyTimers(curl_async, 100'000);
+
+    CURL_async_destroy(curl_async);
+}
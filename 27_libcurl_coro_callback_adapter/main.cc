@@ -0,0 +1,517 @@
+#include <print>
+#include <string>
+#include <functional>
+#include <unordered_map>
+#include <optional>
+#include <coroutine>
+#include <chrono>
+#include <tuple>
+#include <type_traits>
+#include <atomic>
+#include <new>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+#include <curl/curl.h>
+
+#if defined(NDEBUG)
+#  undef NDEBUG
+#endif
+#include <cassert>
+
+// libcurl bookkeeping
+using CURL_Async = void*;
+CURL_Async CURL_async_create();
+void CURL_async_destroy(CURL_Async curl_async);
+void CURL_async_tick(CURL_Async curl_async);
+// sleeps until socket activity, a libcurl timeout or `timeout`,
+// whichever comes first
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout);
+
+// main async callback API
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response));
+
+static size_t CURL_OnWriteCallback(void* ptr, size_t size, size_t nmemb, void* data)
+{
+    std::string& response = *static_cast<std::string*>(data);
+    response.append(static_cast<const char*>(ptr), size * nmemb);
+    return (size * nmemb);
+}
+
+struct CURL_AsyncScheduler
+{
+    CURL_AsyncScheduler();
+    ~CURL_AsyncScheduler();
+    // no copy, no move
+    CURL_AsyncScheduler(const CURL_AsyncScheduler&) = delete;
+
+    using Callback = std::function<void (CURL* curl_easy)>;
+
+    void tick();
+    void add_request(CURL* curl_easy, Callback on_finish);
+
+    // our state
+    CURLM* _multi_curl = nullptr;
+    std::unordered_map<CURL*, Callback> _curl_to_callback;
+};
+
+CURL_AsyncScheduler::CURL_AsyncScheduler()
+{
+    const CURLcode status = curl_global_init(CURL_GLOBAL_ALL);
+    assert(status == CURLE_OK);
+    _multi_curl = curl_multi_init();
+    assert(_multi_curl);
+}
+
+CURL_AsyncScheduler::~CURL_AsyncScheduler()
+{
+    const CURLMcode status = curl_multi_cleanup(_multi_curl);
+    assert(status == CURLM_OK);
+    curl_global_cleanup();
+}
+
+void CURL_AsyncScheduler::tick()
+{
+    int running_handles = -1;
+    CURLMcode status = curl_multi_perform(_multi_curl, &running_handles);
+    assert(status == CURLM_OK);
+    int msgs_in_queue = 0;
+    while (CURLMsg* m = curl_multi_info_read(_multi_curl, &msgs_in_queue))
+    {
+        if (m->msg != CURLMSG_DONE)
+        {
+            continue;
+        }
+        CURL* curl_easy = m->easy_handle;
+        assert(curl_easy);
+        status = curl_multi_remove_handle(_multi_curl, curl_easy);
+        assert(status == CURLM_OK);
+        auto it = _curl_to_callback.find(curl_easy);
+        assert(it != _curl_to_callback.end());
+        Callback callback = std::move(it->second);
+        assert(callback);
+        (void)_curl_to_callback.erase(it);
+        callback(curl_easy);
+    }
+}
+
+void CURL_AsyncScheduler::add_request(CURL* curl_easy, Callback on_finish)
+{
+    assert(on_finish);
+    assert(curl_easy);
+    assert(!_curl_to_callback.contains(curl_easy));
+    const CURLMcode status = curl_multi_add_handle(_multi_curl, curl_easy);
+    assert(status == CURLM_OK);
+    _curl_to_callback[curl_easy] = std::move(on_finish);
+}
+
+CURL_Async CURL_async_create()
+{
+    CURL_AsyncScheduler* scheduler = new(std::nothrow) CURL_AsyncScheduler();
+    assert(scheduler);
+    return scheduler;
+}
+
+void CURL_async_destroy(CURL_Async curl_async)
+{
+    assert(curl_async);
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    delete scheduler;
+}
+
+static CURL_AsyncScheduler& CURL_scheduler(CURL_Async curl_async)
+{
+    CURL_AsyncScheduler* scheduler = static_cast<CURL_AsyncScheduler*>(curl_async);
+    assert(scheduler);
+    return *scheduler;
+}
+
+void CURL_async_tick(CURL_Async curl_async)
+{
+    CURL_scheduler(curl_async).tick();
+}
+
+void CURL_async_wait(CURL_Async curl_async, std::chrono::milliseconds timeout)
+{
+    // curl_multi_poll() itself caps the wait by libcurl's own timers
+    const CURLMcode status = curl_multi_poll(CURL_scheduler(curl_async)._multi_curl
+        , nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    assert(status == CURLM_OK);
+}
+
+void CURL_async_get(CURL_Async curl_async
+    , const std::string& url
+    , void* user_data
+    , void (*callback)(void* user_data, std::string response))
+{
+    // 1. setup curl easy handle
+    CURL* curl_easy = curl_easy_init();
+    assert(curl_easy);
+    CURLcode status = curl_easy_setopt(curl_easy, CURLOPT_URL, url.c_str());
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_FOLLOWLOCATION, 1L);
+    assert(status == CURLE_OK);
+
+    // 2. write response data to separate std::string
+    std::string* state = new std::string{};
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEFUNCTION, CURL_OnWriteCallback);
+    assert(status == CURLE_OK);
+    status = curl_easy_setopt(curl_easy, CURLOPT_WRITEDATA, state);
+    assert(status == CURLE_OK);
+
+    // 3. associate with multi handle/event loop
+    CURL_scheduler(curl_async).add_request(curl_easy
+        , [state, user_data, callback](CURL* curl_easy_)
+    {
+        long response_code = -1;
+        const CURLcode status_ = curl_easy_getinfo(curl_easy_, CURLINFO_RESPONSE_CODE, &response_code);
+        assert(status_ == CURLE_OK);
+        assert(response_code == 200L);
+        curl_easy_cleanup(curl_easy_);
+        std::string data = std::move(*state);
+        delete state;
+        callback(user_data, std::move(data));
+    });
+}
+
+// co_return value storage, void has none
+template<typename T>
+struct Co_TaskResult
+{
+    void return_value(T value)
+    {
+        _result.emplace(std::move(value));
+    }
+
+    T take_result()
+    {
+        assert(_result);
+        return std::move(*_result);
+    }
+
+    std::optional<T> _result;
+};
+
+template<>
+struct Co_TaskResult<void>
+{
+    void return_void()
+    {
+        // yeah, we return void. Nothing to do
+    }
+
+    void take_result()
+    {
+    }
+};
+
+template<typename T = void>
+struct Co_Task
+{
+    struct promise_type;
+    using co_handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type : Co_TaskResult<T>
+    {
+        Co_Task get_return_object()
+        {
+            return Co_Task{co_handle::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend()
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void unhandled_exception()
+        {
+            // crash, no exceptions handling
+            assert(false);
+        }
+    };
+
+    Co_Task(co_handle coro)
+        : _coro{coro} {}
+    Co_Task(Co_Task&& rhs) noexcept
+        : _coro{std::exchange(rhs._coro, {})} { }
+    Co_Task(const Co_Task&) = delete;
+    ~Co_Task() noexcept
+    {
+        if (_coro)
+        {
+            _coro.destroy();
+        }
+    }
+
+    void resume()
+    {
+        assert(_coro);
+        assert(!_coro.done());
+        _coro.resume();
+    }
+
+    bool is_in_progress() const
+    {
+        assert(_coro);
+        return !_coro.done();
+    }
+
+    T take_result()
+    {
+        assert(_coro);
+        assert(_coro.done());
+        return _coro.promise().take_result();
+    }
+
+    co_handle _coro;
+};
+
+// runs `task` to completion on this thread and returns its co_return value.
+// Between ticks the thread sleeps in curl_multi_poll(); the task can only
+// make progress from tick(), so it's checked right after each one
+template<typename T>
+T sync_wait(CURL_Async curl_async, Co_Task<T> task)
+{
+    task.resume();
+    while (task.is_in_progress())
+    {
+        CURL_async_tick(curl_async);
+        if (!task.is_in_progress())
+        {
+            break;
+        }
+        // upper bound only, socket activity and libcurl timers wake earlier
+        CURL_async_wait(curl_async, std::chrono::milliseconds{1000});
+    }
+    return task.take_result();
+}
+
+// turns any C-style async function whose last two parameters are
+// `void* user_data, void (*callback)(void* user_data, Results...)` into an
+// awaitable: `co_await Co_from_callback<&Fn>(args...)`. Arguments, result
+// and coroutine handle live in the awaiter, i.e. in the coroutine frame.
+// co_await yields void, the single result, or std::tuple<Results...>
+template<typename Fn>
+struct Co_FunctionTraits;
+
+template<typename R, typename... Params>
+struct Co_FunctionTraits<R (*)(Params...)>
+{
+    static_assert(sizeof...(Params) >= 2, "expected (..., void* user_data, callback)");
+    using UserData = std::tuple_element_t<sizeof...(Params) - 2, std::tuple<Params...>>;
+    using Callback = std::tuple_element_t<sizeof...(Params) - 1, std::tuple<Params...>>;
+    static_assert(std::is_same_v<UserData, void*>, "expected (..., void* user_data, callback)");
+};
+
+template<typename Callback>
+struct Co_CallbackTraits;
+
+template<typename... Results>
+struct Co_CallbackTraits<void (*)(void*, Results...)>
+{
+    using Result = std::conditional_t<(sizeof...(Results) == 0), void
+        , std::conditional_t<(sizeof...(Results) == 1)
+            , std::decay_t<std::tuple_element_t<0, std::tuple<Results..., void>>>
+            , std::tuple<std::decay_t<Results>...>>>;
+
+    // matches `callback` exactly, so it converts to the C function pointer
+    template<typename Awaiter>
+    static void on_complete(void* user_data, Results... results)
+    {
+        Awaiter& self = *static_cast<Awaiter*>(user_data);
+        self._result.set(std::forward<Results>(results)...);
+        self.on_complete();
+    }
+};
+
+// result slot, void has none
+template<typename T>
+struct Co_CallbackResult
+{
+    template<typename... Results>
+    void set(Results&&... results)
+    {
+        _value.emplace(std::forward<Results>(results)...);
+    }
+
+    T take()
+    {
+        assert(_value);
+        return std::move(*_value);
+    }
+
+    std::optional<T> _value;
+};
+
+template<>
+struct Co_CallbackResult<void>
+{
+    void set()
+    {
+    }
+
+    void take()
+    {
+    }
+};
+
+template<auto Fn, typename... Args>
+struct Co_CallbackAwaiter
+{
+    using Traits = Co_CallbackTraits<typename Co_FunctionTraits<decltype(Fn)>::Callback>;
+    using Result = typename Traits::Result;
+
+    enum class State
+    {
+        Starting,
+        Waiting,
+        Done,
+    };
+
+    std::tuple<Args...> _args;
+    std::coroutine_handle<> _coro{};
+    State _state = State::Starting;
+    Co_CallbackResult<Result> _result{};
+
+    bool await_ready()
+    { // 1. nothing is started yet, go to await_suspend():
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> coro)
+    { // 2. start; don't suspend if the callback already ran, synchronously:
+        _coro = coro;
+        _state = State::Starting;
+        std::apply([this](Args&... args)
+        {
+            (void)Fn(args..., this, &Traits::template on_complete<Co_CallbackAwaiter>);
+        }, _args);
+        if (_state == State::Done)
+        {
+            return false;
+        }
+        _state = State::Waiting;
+        return true;
+    }
+
+    Result await_resume()
+    { // 3. after resume, return result:
+        return _result.take();
+    }
+
+    void on_complete()
+    {
+        if (_state == State::Starting)
+        {   // still inside Fn(), await_suspend() will see it
+            _state = State::Done;
+            return;
+        }
+        assert(_state == State::Waiting);
+        _state = State::Done;
+        _coro.resume();
+    }
+};
+
+template<auto Fn, typename... Args>
+Co_CallbackAwaiter<Fn, std::decay_t<Args>...> Co_from_callback(Args&&... args)
+{
+    return Co_CallbackAwaiter<Fn, std::decay_t<Args>...>{
+        std::tuple<std::decay_t<Args>...>{std::forward<Args>(args)...}};
+}
+
+// what used to be a hand-written Co_CurlAsync
+auto CURL_await_get(CURL_Async curl_async, const std::string& url)
+{
+    return Co_from_callback<&CURL_async_get>(curl_async, url);
+}
+
+// "other" C libraries with the same callback style: completion may come
+// right away, with several results, or with none
+static void App_async_checksum(const char* data, std::size_t size
+    , void* user_data
+    , void (*callback)(void* user_data, unsigned checksum, std::size_t size))
+{
+    unsigned checksum = 0;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        checksum = (checksum * 31u) + static_cast<unsigned char>(data[i]);
+    }
+    callback(user_data, checksum, size);
+}
+
+struct App_Log
+{
+    std::string pending;
+};
+
+static void App_async_flush(App_Log* log
+    , void* user_data
+    , void (*callback)(void* user_data))
+{
+    std::print("{}", log->pending);
+    log->pending.clear();
+    callback(user_data);
+}
+
+// only our side: libcurl still does its own malloc() per transfer
+static std::atomic<std::uint64_t> g_App_allocations{0};
+
+void* operator new(std::size_t size)
+{
+    g_App_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+static Co_Task<std::size_t> coro_main(CURL_Async curl_async, App_Log& log)
+{
+    const std::string response = co_await CURL_await_get(
+        curl_async, "localhost:5001/file1.txt");
+
+    const std::uint64_t allocations = g_App_allocations.load(std::memory_order_relaxed);
+    const auto [checksum, size] = co_await Co_from_callback<&App_async_checksum>(
+        response.data(), response.size());
+    const std::uint64_t adapter_allocations = g_App_allocations.load(std::memory_order_relaxed) - allocations;
+
+    log.pending = "response: '" + response + "', checksum: " + std::to_string(checksum)
+        + ", size: " + std::to_string(size)
+        + ", adapter allocations: " + std::to_string(adapter_allocations) + "\n";
+    co_await Co_from_callback<&App_async_flush>(&log);
+    assert(log.pending.empty());
+    co_return size;
+}
+
+int main()
+{
+    CURL_Async curl_async = CURL_async_create();
+    App_Log log;
+    const std::size_t bytes = sync_wait(curl_async, coro_main(curl_async, log));
+    assert(bytes > 0);
+    CURL_async_destroy(curl_async);
+
+    std::println("awaiter size, get: {} bytes, checksum: {} bytes"
+        , sizeof(decltype(CURL_await_get(curl_async, "")))
+        , sizeof(Co_CallbackAwaiter<&App_async_checksum, const char*, std::size_t>));
+}